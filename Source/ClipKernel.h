@@ -0,0 +1,313 @@
+#pragma once
+#include "SimdOps.h"
+#include <cmath>
+
+// Block-constant settings for the rounded soft clipper. Derived values
+// (knee start, knee width) are computed once per block in the constructor.
+struct ClipParams
+{
+    ClipParams(float preGain, float ceiling, float softness, float driveLin, float mixAmt) noexcept
+        : pre(preGain), drive(driveLin), mix(mixAmt)
+    {
+        const float s = softness < 0.0f ? 0.0f : (softness > 1.0f ? 1.0f : softness);
+        tFrac     = 1.0f - 0.6f * s;
+        kneeScale = 1.0f / (0.6f * s > 1.0e-12f ? 0.6f * s : 1.0e-12f);
+        c = ceiling > 1.0e-6f ? ceiling : 1.0e-6f;
+        t = c * tFrac;
+        const float kw = c - t;
+        invKnee = 1.0f / (kw > 1.0e-12f ? kw : 1.0e-12f);
+    }
+
+    float pre, drive, mix;
+    float c, t, invKnee;
+    float tFrac, kneeScale;
+};
+
+// Per-sample values for one chunk when any clipper parameter is smoothing.
+// `start` holds each value just before the chunk so the ramps can be
+// expanded linearly to the oversampled rate.
+struct ClipRamps
+{
+    enum { pre, ceil, drive, mix, numRamps };
+    const float* data[numRamps];
+    float start[numRamps];
+};
+
+static inline void expandRamp(float* dst, const float* src, float prev, int n, int factor) noexcept
+{
+    const float inv = 1.0f / (float) factor;
+    for (int i = 0; i < n; ++i)
+    {
+        const float step = (src[i] - prev) * inv;
+        for (int k = 0; k < factor; ++k) *dst++ = prev + step * (float) (k + 1);
+        prev = src[i];
+    }
+}
+
+// Branchless form of softClipRounded: below the knee min(a, t) passes |u|
+// through and H(0) = 0; above the ceiling v saturates at 1 and H(1) = 1.
+// The outer min keeps t + (c - t) from rounding above c.
+template <typename V>
+static inline V softClipRoundedV(V u, V t, V c, V invKnee) noexcept
+{
+    const V one  = V::set(1.0f);
+    const V a    = V::abs(u);
+    const V v    = V::min(V::max((a - t) * invKnee, V::set(0.0f)), one);
+    const V H    = ((one - v) * v + one) * v;
+    return V::copySign(V::min(V::min(a, t) + (c - t) * H, c), u);
+}
+
+template <typename V, bool Blend>
+static inline void clipFinish(typename V::value_type* d, V dry, V y, V mix, V c) noexcept
+{
+    if constexpr (Blend)
+    {
+        const V m = mix * y + (V::set(1.0f) - mix) * dry;
+        V::min(V::max(m, V::set(0.0f) - c), c).store(d);
+    }
+    else
+    {
+        y.store(d);
+    }
+}
+
+template <typename V, bool HasGain, bool Blend>
+static inline int clipLanes(typename V::value_type* d, const float* gain, const ClipParams& k) noexcept
+{
+    const V c   = V::set(k.c);
+    const V dry = V::load(d);
+    V x = dry * V::set(k.pre);
+    if constexpr (HasGain) x = x * V::load(gain);
+
+    const V u = x * V::set(k.drive);
+    const int clipped = V::countGreater(V::abs(u), c);
+    clipFinish<V, Blend>(d, dry, softClipRoundedV(u, V::set(k.t), c, V::set(k.invKnee)), V::set(k.mix), c);
+    return clipped;
+}
+
+template <typename V, bool HasGain, bool Blend>
+static inline int clipLanesRamped(typename V::value_type* d, const float* gain, const float* const* r, int i, const ClipParams& k) noexcept
+{
+    const V c   = V::max(V::load(r[ClipRamps::ceil] + i), V::set(1.0e-6f));
+    const V dry = V::load(d + i);
+    V x = dry * V::load(r[ClipRamps::pre] + i);
+    if constexpr (HasGain) x = x * V::load(gain + i);
+
+    const V u = x * V::load(r[ClipRamps::drive] + i);
+    const int clipped = V::countGreater(V::abs(u), c);
+    clipFinish<V, Blend>(d + i, dry, softClipRoundedV(u, c * V::set(k.tFrac), c, V::set(k.kneeScale) / c), V::load(r[ClipRamps::mix] + i), c);
+    return clipped;
+}
+
+// Runs pregain, optional per-sample gain, drive, soft clip, dry/wet blend
+// and the ceiling clamp in place. Returns the number of samples whose
+// clipper input exceeded the ceiling. Without Blend the output is the
+// clipper alone, which never exceeds the ceiling, so the clamp is skipped.
+// Audio is float or double at the matching lane width; the per-sample gain
+// and ramps stay float.
+template <bool HasGain, bool Blend, typename T>
+static inline int clipBlock(T* d, int n, const ClipParams& k, const float* gain = nullptr) noexcept
+{
+    using V = typename SimdFor<T>::Wide;
+    using S = typename SimdFor<T>::Scalar;
+    int clipped = 0, i = 0;
+    for (; i + V::width <= n; i += V::width)
+        clipped += clipLanes<V, HasGain, Blend>(d + i, gain + (HasGain ? i : 0), k);
+    for (; i < n; ++i)
+        clipped += clipLanes<S, HasGain, Blend>(d + i, gain + (HasGain ? i : 0), k);
+    return clipped;
+}
+
+// Same as clipBlock, with pregain, ceiling, drive and mix read per sample
+// from `r` (indexed by ClipRamps). Shape still comes from `k`.
+template <bool HasGain, bool Blend, typename T>
+static inline int clipBlockRamped(T* d, int n, const ClipParams& k, const float* const* r, const float* gain = nullptr) noexcept
+{
+    using V = typename SimdFor<T>::Wide;
+    using S = typename SimdFor<T>::Scalar;
+    int clipped = 0, i = 0;
+    for (; i + V::width <= n; i += V::width)
+        clipped += clipLanesRamped<V, HasGain, Blend>(d, gain, r, i, k);
+    for (; i < n; ++i)
+        clipped += clipLanesRamped<S, HasGain, Blend>(d, gain, r, i, k);
+    return clipped;
+}
+
+// softClipRounded and its first two antiderivatives, in double, for
+// antiderivative anti-aliasing. For a = |u| the curve is a below the knee
+// start t, t + w * H((a - t) / w) inside the knee (w = c - t) and c above
+// it, with H(v) = v + v^2 - v^3. Integrating H gives
+// G1(v) = v^2/2 + v^3/3 - v^4/4 and G2(v) = v^3/6 + v^4/12 - v^5/20.
+// f is odd, so F1 is even and F2 odd.
+struct SoftClipCurve
+{
+    SoftClipCurve(double knee, double ceiling) noexcept
+        : t(knee), c(ceiling), w(ceiling - knee)
+    {
+        f1c = 0.5 * t * t + t * w + w * w * (7.0 / 12.0);
+        f2c = t * t * t / 6.0 + 0.5 * t * t * w + 0.5 * t * w * w + w * w * w * 0.2;
+    }
+
+    double f(double u) const noexcept
+    {
+        const double a = std::abs(u);
+        double y;
+        if (a <= t)      y = a;
+        else if (a >= c) y = c;
+        else { const double v = (a - t) / w; y = t + w * (v + v * v - v * v * v); }
+        return u < 0.0 ? -y : y;
+    }
+
+    double F1(double u) const noexcept
+    {
+        const double a = std::abs(u);
+        if (a <= t) return 0.5 * a * a;
+        if (a >= c) return f1c + c * (a - c);
+        const double v = (a - t) / w;
+        return 0.5 * t * t + t * (a - t) + w * w * (v * v * (0.5 + v * (1.0 / 3.0 - 0.25 * v)));
+    }
+
+    double F2(double u) const noexcept
+    {
+        const double a = std::abs(u);
+        double y;
+        if (a <= t)      y = a * a * a / 6.0;
+        else if (a >= c) { const double e = a - c; y = f2c + f1c * e + 0.5 * c * e * e; }
+        else
+        {
+            const double e = a - t, v = e / w;
+            y = t * t * t / 6.0 + 0.5 * t * t * e + 0.5 * t * e * e
+              + w * w * w * (v * v * v * (1.0 / 6.0 + v * (1.0 / 12.0 - 0.05 * v)));
+        }
+        return u < 0.0 ? -y : y;
+    }
+
+    double t, c, w, f1c, f2c;
+};
+
+// Per-channel history for the ADAA clip modes: the last two clipper inputs,
+// their cached antiderivative terms, the knee and ceiling of the curve those
+// terms were computed with, and the last dry sample.
+struct AdaaState
+{
+    double x1 = 0.0, x2 = 0.0, F1 = 0.0, F2 = 0.0, D1 = 0.0;
+    double t = 0.0, c = 0.0;
+    double dry1 = 0.0;
+};
+
+// First-order ADAA delays the curve by half a sample and second-order by
+// one; the dry signal is delayed to match before blending. The cached terms
+// are recomputed whenever the curve differs from the one they came from,
+// whether it ramps or steps between blocks.
+template <int Order>
+static inline double adaaSample(double x, const SoftClipCurve& s, AdaaState& st) noexcept
+{
+    const bool curveMoved = s.t != st.t || s.c != st.c;
+    st.t = s.t; st.c = s.c;
+
+    if constexpr (Order == 1)
+    {
+        constexpr double tol = 1.0e-6;
+        const double fx = s.F1(x);
+        const double f1 = curveMoved ? s.F1(st.x1) : st.F1;
+        const double dx = x - st.x1;
+        const double y = std::abs(dx) > tol ? (fx - f1) / dx : s.f(0.5 * (x + st.x1));
+        st.x1 = x; st.F1 = fx;
+        return y;
+    }
+    else
+    {
+        constexpr double tol = 1.0e-4;
+        // D(a, b) = (F2(a) - F2(b)) / (a - b), falling back to F1 of the
+        // midpoint when a and b are too close for the difference to be exact.
+        auto D = [&](double a, double fa, double b, double fb)
+        {
+            return std::abs(a - b) > tol ? (fa - fb) / (a - b) : s.F1(0.5 * (a + b));
+        };
+
+        const double fx = s.F2(x);
+        double d1 = st.D1;
+        double f1 = st.F2;
+        if (curveMoved) { f1 = s.F2(st.x1); d1 = D(st.x1, f1, st.x2, s.F2(st.x2)); }
+        const double d0 = D(x, fx, st.x1, f1);
+
+        double y;
+        const double span = x - st.x2;
+        if (std::abs(span) > tol)
+        {
+            y = 2.0 * (d0 - d1) / span;
+        }
+        else
+        {
+            // x and x[n-2] nearly coincide: expand around their midpoint.
+            const double m = 0.5 * (x + st.x2), delta = m - st.x1;
+            y = std::abs(delta) > tol ? 2.0 * (s.F1(m) + (s.F2(st.x1) - s.F2(m)) / delta) / delta
+                                      : s.f(0.5 * (m + st.x1));
+        }
+        st.x2 = st.x1; st.x1 = x; st.F2 = fx; st.D1 = d0;
+        return y;
+    }
+}
+
+// Same contract as clipBlock / clipBlockRamped, for the ADAA clip modes.
+// Runs sample by sample in double; `r` is null unless parameters ramp.
+template <int Order, bool HasGain, bool Blend, typename T>
+static inline int clipBlockAdaa(T* d, int n, const ClipParams& k, const float* const* r,
+                                const float* gain, AdaaState& st) noexcept
+{
+    int clipped = 0;
+    SoftClipCurve curve(k.t, k.c);
+    for (int i = 0; i < n; ++i)
+    {
+        float pre = k.pre, drive = k.drive, mix = k.mix, c = k.c;
+        if (r != nullptr)
+        {
+            pre = r[ClipRamps::pre][i]; drive = r[ClipRamps::drive][i]; mix = r[ClipRamps::mix][i];
+            c = r[ClipRamps::ceil][i] > 1.0e-6f ? r[ClipRamps::ceil][i] : 1.0e-6f;
+            curve = SoftClipCurve((double) (c * k.tFrac), (double) c);
+        }
+
+        const T dry = d[i];
+        T u = dry * (T) pre * (T) drive;
+        if constexpr (HasGain) u *= (T) gain[i];
+        clipped += std::abs(u) > (T) c ? 1 : 0;
+
+        const T y = (T) adaaSample<Order>((double) u, curve, st);
+        if constexpr (Blend)
+        {
+            const T dryAligned = (T) (Order == 1 ? 0.5 * (dry + st.dry1) : st.dry1);
+            const T m = (T) mix * y + (T) (1.0f - mix) * dryAligned;
+            d[i] = m < (T) -c ? (T) -c : (m > (T) c ? (T) c : m);
+            st.dry1 = dry;
+        }
+        else
+        {
+            // The difference quotients can land a rounding error past c.
+            d[i] = y < (T) -c ? (T) -c : (y > (T) c ? (T) c : y);
+        }
+    }
+    return clipped;
+}
+
+// Blends `dry` under a block that has already been clipped without Blend,
+// then clamps to the ceiling. For the ADAA modes the dry signal is aligned
+// the same way clipBlockAdaa aligns it, with `dryPrev` carrying the last
+// dry sample across blocks.
+template <int Order, typename T>
+static inline void blendDry(T* d, const T* dry, int n, const ClipParams& k,
+                            const float* const* r, double& dryPrev) noexcept
+{
+    for (int i = 0; i < n; ++i)
+    {
+        float mix = k.mix, c = k.c;
+        if (r != nullptr)
+        {
+            mix = r[ClipRamps::mix][i];
+            c = r[ClipRamps::ceil][i] > 1.0e-6f ? r[ClipRamps::ceil][i] : 1.0e-6f;
+        }
+        const T aligned = Order == 0 ? dry[i] : (T) (Order == 1 ? 0.5 * (dry[i] + dryPrev) : dryPrev);
+        const T m = (T) mix * d[i] + (T) (1.0f - mix) * aligned;
+        d[i] = m < (T) -c ? (T) -c : (m > (T) c ? (T) c : m);
+        dryPrev = dry[i];
+    }
+}
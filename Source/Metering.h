@@ -0,0 +1,348 @@
+#pragma once
+#include "TruePeakLimiter.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Everything the meters publish, refreshed every 100 ms of audio. Levels are
+// in dB / LUFS with -inf replaced by `floorDb`.
+struct MeterSnapshot
+{
+    static constexpr float floorDb = -100.0f;
+    static constexpr int clipHistoryLength = 60;
+
+    float peakDb = floorDb, truePeakDb = floorDb;            // last 100 ms
+    float peakHoldDb = floorDb, truePeakHoldDb = floorDb;    // since reset
+    float gainReductionDb = 0.0f, maxGainReductionDb = 0.0f; // true-peak limiter, <= 0
+    float momentaryLufs = floorDb, shortTermLufs = floorDb, integratedLufs = floorDb;
+    float clipRatio = 0.0f;                                  // last 100 ms
+    uint64_t clippedSamples = 0, consideredSamples = 0;      // since reset
+
+    // Clipped samples per second over the last minute, oldest first.
+    uint32_t clipHistory[clipHistoryLength] = {};
+};
+
+// Single-writer seqlock. The payload is stored as relaxed atomic words, so a
+// torn read is detected and retried rather than being a data race.
+template <typename T>
+class SeqLockSnapshot
+{
+public:
+    void publish(const T& value) noexcept
+    {
+        uint32_t words[numWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < numWords; ++i) data[i].store(words[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Returns false if the writer kept overlapping the read.
+    bool read(T& out) const noexcept
+    {
+        for (int attempt = 0; attempt < 16; ++attempt)
+        {
+            const uint32_t s0 = seq.load(std::memory_order_acquire);
+            if ((s0 & 1u) != 0) continue;
+
+            uint32_t words[numWords];
+            for (size_t i = 0; i < numWords; ++i) words[i] = data[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) != s0) continue;
+
+            std::memcpy(&out, words, sizeof(T));
+            return true;
+        }
+        return false;
+    }
+
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "seqlock payload must be trivially copyable");
+    static constexpr size_t numWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> seq { 0 };
+    std::array<std::atomic<uint32_t>, numWords> data {};
+};
+
+// Output meters, run on the audio thread without allocation: sample and
+// true peak, limiter gain reduction, clip statistics and ITU-R BS.1770-4
+// loudness. Loudness is measured over 100 ms steps; momentary is the last
+// 4 steps, short-term the last 30, and integrated uses a 0.1 LU histogram
+// of momentary blocks so gating needs no block list.
+class MeterEngine
+{
+public:
+    // `channelWeights` are the BS.1770 weights (0 for LFE, 1.41 for surrounds).
+    void prepare(double sampleRate, const std::vector<float>& channelWeights)
+    {
+        channels = (int) channelWeights.size();
+        weights  = channelWeights;
+        stepLength = std::max(1, (int) std::lround(sampleRate * 0.1));
+
+        // K-weighting: high shelf then RLB high-pass, designed for this rate.
+        const double pi = 3.14159265358979323846;
+        {
+            const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+            const double k  = std::tan(pi * f0 / sampleRate);
+            const double vh = std::pow(10.0, gainDb / 20.0), vb = std::pow(vh, 0.4996667741545416);
+            const double a0 = 1.0 + k / q + k * k;
+            shelf = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                      2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+        }
+        {
+            const double f0 = 38.13547087602444, q = 0.5003270373238773;
+            const double k  = std::tan(pi * f0 / sampleRate);
+            const double a0 = 1.0 + k / q + k * k;
+            highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+        }
+
+        filterState.assign((size_t) channels * 4, 0.0);
+        stepEnergy.assign((size_t) channels, 0.0);
+        truePeakDetector.prepare(channels);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill(filterState.begin(), filterState.end(), 0.0);
+        std::fill(stepEnergy.begin(), stepEnergy.end(), 0.0);
+        truePeakDetector.reset();
+        steps.fill(0.0);
+        stepWeights.fill(0.0);
+        stepCount = stepPos = stepFill = 0;
+        gateCounts.fill(0);
+        gateEnergy.fill(0.0);
+        clipBins.fill(0);
+        clipBinPos = 0;
+        clipBinFill = 0;
+        stepPeak = stepTruePeak = peakHold = truePeakHold = 0.0f;
+        stepMinGain = minGainHold = 1.0f;
+        stepClipped = stepConsidered = 0;
+        totalClipped = totalConsidered = 0;
+        published.publish(MeterSnapshot {});
+    }
+
+    // Feeds one block of output. Clip counts and the limiter's smallest gain
+    // cover the whole block and are booked to the step the block ends in.
+    template <typename T>
+    void process(const T* const* data, int numChannels, int numSamples,
+                 int clipped, int considered, float limiterMinGain) noexcept
+    {
+        const int nch = std::min(numChannels, channels);
+        stepClipped    += (uint64_t) std::max(0, clipped);
+        stepConsidered += (uint64_t) std::max(0, considered);
+        stepMinGain     = std::min(stepMinGain, limiterMinGain);
+
+        for (int start = 0; start < numSamples;)
+        {
+            const int n = std::min(numSamples - start, stepLength - stepFill);
+            for (int ch = 0; ch < nch; ++ch)
+                measureChannel(ch, data[ch] + start, n);
+
+            start    += n;
+            stepFill += n;
+            if (stepFill == stepLength) finishStep();
+        }
+    }
+
+    // Feeds a block of digital silence without running the filters. Only
+    // valid once the output has been silent long enough for them to ring
+    // out; their state is cleared, which is where silence leaves it.
+    void processSilence(int numSamples, int considered) noexcept
+    {
+        std::fill(filterState.begin(), filterState.end(), 0.0);
+        truePeakDetector.reset();
+        stepConsidered += (uint64_t) std::max(0, considered);
+
+        for (int start = 0; start < numSamples;)
+        {
+            const int n = std::min(numSamples - start, stepLength - stepFill);
+            start    += n;
+            stepFill += n;
+            if (stepFill == stepLength) finishStep();
+        }
+    }
+
+    // Publishes the partly filled step, if any. For the end of an offline
+    // render, where the last block rarely ends on a step boundary. The step
+    // counts in the momentary and short-term windows for its actual length
+    // and is left out of the integrated gate, which only takes whole 400 ms
+    // blocks on the 100 ms grid.
+    void flush() noexcept
+    {
+        if (stepFill > 0) finishStep();
+    }
+
+    void read(MeterSnapshot& out) const noexcept { published.read(out); }
+
+private:
+    struct Biquad { double b0, b1, b2, a1, a2; };
+
+    static inline float toDb(float lin) noexcept
+    {
+        return lin > 1.0e-5f ? 20.0f * std::log10(lin) : MeterSnapshot::floorDb;
+    }
+
+    static inline float toLufs(double meanSquare) noexcept
+    {
+        return meanSquare > 1.0e-10 ? (float) (-0.691 + 10.0 * std::log10(meanSquare)) : MeterSnapshot::floorDb;
+    }
+
+    template <typename T>
+    void measureChannel(int ch, const T* x, int n) noexcept
+    {
+        double* z = filterState.data() + (size_t) ch * 4;
+        double s1 = z[0], s2 = z[1], h1 = z[2], h2 = z[3], energy = 0.0;
+        float peak = stepPeak, tp = stepTruePeak;
+
+        for (int i = 0; i < n; ++i)
+        {
+            const double in = (double) x[i];
+            const double y  = shelf.b0 * in + s1;
+            s1 = shelf.b1 * in - shelf.a1 * y + s2;
+            s2 = shelf.b2 * in - shelf.a2 * y;
+
+            const double k = highPass.b0 * y + h1;
+            h1 = highPass.b1 * y - highPass.a1 * k + h2;
+            h2 = highPass.b2 * y - highPass.a2 * k;
+            energy += k * k;
+
+            const float xf = (float) x[i];
+            peak = std::max(peak, std::abs(xf));
+            tp   = std::max(tp, truePeakDetector.process(ch, xf));
+        }
+
+        z[0] = s1; z[1] = s2; z[2] = h1; z[3] = h2;
+        stepEnergy[(size_t) ch] += energy;
+        stepPeak = peak;
+        stepTruePeak = tp;
+    }
+
+    void finishStep() noexcept
+    {
+        double e = 0.0;
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            e += (double) weights[(size_t) ch] * stepEnergy[(size_t) ch] / (double) stepFill;
+            stepEnergy[(size_t) ch] = 0.0;
+        }
+        const bool whole = stepFill == stepLength;
+        steps[(size_t) stepPos] = e;
+        stepWeights[(size_t) stepPos] = (double) stepFill / (double) stepLength;
+        stepPos = (stepPos + 1) % historySteps;
+        stepCount = std::min(stepCount + 1, shortTermSteps);
+
+        const double momentary = meanOfLastSteps(momentarySteps);
+        const double shortTerm = meanOfLastSteps(shortTermSteps);
+        if (whole && stepCount >= momentarySteps) addToGate(momentary);
+
+        peakHold     = std::max(peakHold, stepPeak);
+        truePeakHold = std::max(truePeakHold, stepTruePeak);
+        minGainHold  = std::min(minGainHold, stepMinGain);
+        totalClipped    += stepClipped;
+        totalConsidered += stepConsidered;
+
+        // Ten steps make one second of clip history.
+        clipBins[(size_t) clipBinPos] += (uint32_t) std::min<uint64_t>(stepClipped, 0xffffffffu - clipBins[(size_t) clipBinPos]);
+        if (++clipBinFill == 10)
+        {
+            clipBinFill = 0;
+            clipBinPos = (clipBinPos + 1) % MeterSnapshot::clipHistoryLength;
+            clipBins[(size_t) clipBinPos] = 0;
+        }
+
+        MeterSnapshot s;
+        s.peakDb             = toDb(stepPeak);
+        s.truePeakDb         = toDb(stepTruePeak);
+        s.peakHoldDb         = toDb(peakHold);
+        s.truePeakHoldDb     = toDb(truePeakHold);
+        s.gainReductionDb    = std::min(0.0f, toDb(stepMinGain));
+        s.maxGainReductionDb = std::min(0.0f, toDb(minGainHold));
+        s.momentaryLufs      = stepCount >= momentarySteps ? toLufs(momentary) : MeterSnapshot::floorDb;
+        s.shortTermLufs      = stepCount >= shortTermSteps ? toLufs(shortTerm) : MeterSnapshot::floorDb;
+        s.integratedLufs     = integratedLoudness();
+        s.clipRatio          = stepConsidered > 0 ? (float) ((double) stepClipped / (double) stepConsidered) : 0.0f;
+        s.clippedSamples     = totalClipped;
+        s.consideredSamples  = totalConsidered;
+        for (int i = 0; i < MeterSnapshot::clipHistoryLength; ++i)
+            s.clipHistory[i] = clipBins[(size_t) ((clipBinPos + 1 + i) % MeterSnapshot::clipHistoryLength)];
+        published.publish(s);
+
+        stepPeak = stepTruePeak = 0.0f;
+        stepMinGain = 1.0f;
+        stepClipped = stepConsidered = 0;
+        stepFill = 0;
+    }
+
+    // Mean square over the last `count` steps' worth of signal, or all there
+    // is. Steps are weighted by their length, so after a short step the
+    // window reaches back into part of the step before the oldest whole one.
+    double meanOfLastSteps(int count) const noexcept
+    {
+        double sum = 0.0, weight = 0.0;
+        for (int i = 1; i <= historySteps && weight < (double) count; ++i)
+        {
+            const size_t k = (size_t) ((stepPos - i + historySteps) % historySteps);
+            const double w = std::min(stepWeights[k], (double) count - weight);
+            sum += steps[k] * w;
+            weight += w;
+        }
+        return weight > 0.0 ? sum / weight : 0.0;
+    }
+
+    void addToGate(double meanSquare) noexcept
+    {
+        const float l = toLufs(meanSquare);
+        if (l < absoluteGate) return;
+        const int bin = std::min(gateBins - 1, (int) ((l - absoluteGate) * 10.0f));
+        ++gateCounts[(size_t) bin];
+        gateEnergy[(size_t) bin] += meanSquare;
+    }
+
+    float integratedLoudness() const noexcept
+    {
+        uint64_t count = 0;
+        double energy = 0.0;
+        for (int b = 0; b < gateBins; ++b) { count += gateCounts[(size_t) b]; energy += gateEnergy[(size_t) b]; }
+        if (count == 0) return MeterSnapshot::floorDb;
+
+        const float relativeGate = toLufs(energy / (double) count) - 10.0f;
+        const int first = std::max(0, (int) std::ceil((relativeGate - absoluteGate) * 10.0f));
+        count = 0;
+        energy = 0.0;
+        for (int b = first; b < gateBins; ++b) { count += gateCounts[(size_t) b]; energy += gateEnergy[(size_t) b]; }
+        return count > 0 ? toLufs(energy / (double) count) : MeterSnapshot::floorDb;
+    }
+
+    static constexpr int momentarySteps = 4, shortTermSteps = 30, historySteps = shortTermSteps + 1;
+    static constexpr float absoluteGate = -70.0f;
+    static constexpr int gateBins = 800; // -70 .. +10 LUFS in 0.1 LU
+
+    int channels = 0, stepLength = 4800, stepFill = 0;
+    std::vector<float> weights;
+    Biquad shelf {}, highPass {};
+    std::vector<double> filterState, stepEnergy;
+    TruePeakDetector truePeakDetector;
+
+    std::array<double, historySteps> steps {}, stepWeights {};
+    int stepPos = 0, stepCount = 0;
+    std::array<uint32_t, gateBins> gateCounts {};
+    std::array<double, gateBins> gateEnergy {};
+
+    std::array<uint32_t, MeterSnapshot::clipHistoryLength> clipBins {};
+    int clipBinPos = 0, clipBinFill = 0;
+
+    float stepPeak = 0.0f, stepTruePeak = 0.0f, peakHold = 0.0f, truePeakHold = 0.0f;
+    float stepMinGain = 1.0f, minGainHold = 1.0f;
+    uint64_t stepClipped = 0, stepConsidered = 0, totalClipped = 0, totalConsidered = 0;
+
+    SeqLockSnapshot<MeterSnapshot> published;
+};
@@ -0,0 +1,271 @@
+#pragma once
+#include "ClipKernel.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// Splits the signal into two to four bands with fourth-order Linkwitz-Riley
+// crossovers, soft clips each band with its own ceiling, shape and drive,
+// and sums the bands back. The bands sit in the four lanes of a Vec4F
+// (Vec4D in the double-precision path):
+// each crossover stage is a pair of Butterworth biquads run lane-parallel
+// with per-lane coefficients, and the band clip is one softClipRoundedV.
+// With four bands the stages are
+//   A: [LP1(x), HP1(x)]
+//   B: [AP2(LP1), LP2(HP1), HP2(HP1)]
+//   C: [AP3(AP2(LP1)), AP3(LP2(HP1)), LP3(HP2(HP1)), HP3(HP2(HP1))]
+// The allpass lanes give the lower bands the phase of the crossovers above
+// them, so unclipped bands sum to an allpass of the input. Fewer bands stop
+// after stage A or B. Unused lanes have all-zero coefficients and stay
+// silent. Filter state is per channel; band settings are shared.
+
+// Band count limit, the same for both sample types.
+constexpr int maxBands = 4;
+
+template <typename T>
+class MultibandClipper
+{
+    using V = typename SimdFor<T>::Quad;
+
+public:
+    static constexpr int maxBands = ::maxBands;
+    static constexpr int maxChannels = 16;
+
+    void prepare(double rate) noexcept
+    {
+        sampleRate = rate;
+        numBands = 0;
+        reset();
+    }
+
+    // Clears the filters and jumps the band settings and crossovers to
+    // their targets.
+    void reset() noexcept
+    {
+        for (auto& ch : state) for (auto& s : ch) s = {};
+        current = target;
+        std::copy(targetCrossovers, targetCrossovers + numStages, crossovers);
+        updateCoeffs();
+    }
+
+    int getNumBands() const noexcept { return numBands; }
+
+    // `freqs` holds numBands - 1 crossover frequencies in Hz. They are kept
+    // ascending, at least a factor of 1.1 apart and at most 0.45 of the
+    // sample rate, and glide to new values chunk by chunk. Where the upper
+    // crossovers run into that limit the lower ones are pushed down to keep
+    // the spacing. A change of band count clears the filters.
+    void setCrossovers(int bands, const float* freqs) noexcept
+    {
+        bands = bands < 2 ? 0 : (bands > maxBands ? maxBands : bands);
+        float f[maxBands - 1] = {};
+        const float top = (float) (0.45 * sampleRate);
+        for (int k = 0; k < bands - 1; ++k)
+        {
+            const float lo = k > 0 ? f[k - 1] * 1.1f : 20.0f;
+            f[k] = std::min(std::max(freqs[k], lo), top);
+        }
+        for (int k = bands - 2; k > 0; --k)
+            f[k - 1] = std::min(f[k - 1], f[k] / 1.1f);
+
+        std::copy(f, f + numStages, targetCrossovers);
+        if (bands != numBands)
+        {
+            numBands = bands;
+            reset();
+        }
+    }
+
+    // Per-band ceiling (linear), shape (0..1) and drive (linear). Ceiling
+    // and drive ramp to the new values over the next chunk; shape steps.
+    void setBands(const float* ceiling, const float* shape, const float* drive) noexcept
+    {
+        for (int b = 0; b < maxBands; ++b)
+        {
+            const ClipParams k(1.0f, ceiling[b], shape[b], drive[b], 1.0f);
+            target.c[b] = (T) k.c;
+            target.drive[b] = (T) k.drive;
+            target.invKnee[b] = (T) k.invKnee;
+            tFrac[b] = (T) k.tFrac;
+        }
+    }
+
+    // Replaces d with the sum of the clipped bands of d * pre * gain, where
+    // pre is per sample when `pre` is non-null and `gain` is optional.
+    void process(T* d, int n, int ch, const float* pre, float preConst, const float* gain) noexcept
+    {
+        chunkLength = n;
+        const bool ramp = ! (current == target);
+        switch (numBands)
+        {
+            case 2: ramp ? run<1, true>(d, n, ch, pre, preConst, gain) : run<1, false>(d, n, ch, pre, preConst, gain); break;
+            case 3: ramp ? run<2, true>(d, n, ch, pre, preConst, gain) : run<2, false>(d, n, ch, pre, preConst, gain); break;
+            case 4: ramp ? run<3, true>(d, n, ch, pre, preConst, gain) : run<3, false>(d, n, ch, pre, preConst, gain); break;
+            default: break;
+        }
+    }
+
+    // Call once every channel of a chunk has been processed. Crossovers
+    // move a step towards their targets in log frequency, smoothed with a
+    // time constant of glideSeconds; coefficients change between chunks only.
+    void finishChunk() noexcept
+    {
+        current = target;
+        if (std::equal(crossovers, crossovers + numStages, targetCrossovers)) return;
+
+        const double a = 1.0 - std::exp(-(double) chunkLength / (glideSeconds * sampleRate));
+        for (int k = 0; k < numBands - 1; ++k)
+        {
+            const double ratio = (double) targetCrossovers[k] / (double) crossovers[k];
+            crossovers[k] = std::abs(ratio - 1.0) < 1.0e-3 ? targetCrossovers[k]
+                                                            : (float) ((double) crossovers[k] * std::pow(ratio, a));
+        }
+        updateCoeffs();
+    }
+
+private:
+    static constexpr int numStages = maxBands - 1;
+    static constexpr double glideSeconds = 0.02;
+    using Biquad = std::array<double, 5>; // b0, b1, b2, a1, a2
+    static constexpr Biquad identity { 1.0, 0.0, 0.0, 0.0, 0.0 };
+
+    struct Filters { Biquad lp, hp, ap; };
+
+    // Second-order Butterworth sections at f. Two lowpass or two highpass
+    // sections in series give the LR4 bands; one allpass matches their sum.
+    Filters butterworth(double f) const noexcept
+    {
+        const double w0 = 2.0 * 3.14159265358979323846 * f / sampleRate;
+        const double cw = std::cos(w0), alpha = std::sin(w0) * 0.70710678118654752;
+        const double a0 = 1.0 + alpha, a1 = -2.0 * cw / a0, a2 = (1.0 - alpha) / a0;
+        Filters r;
+        r.lp = { 0.5 * (1.0 - cw) / a0, (1.0 - cw) / a0, 0.5 * (1.0 - cw) / a0, a1, a2 };
+        r.hp = { 0.5 * (1.0 + cw) / a0, -(1.0 + cw) / a0, 0.5 * (1.0 + cw) / a0, a1, a2 };
+        r.ap = { a2, a1, 1.0, a1, a2 };
+        return r;
+    }
+
+    void updateCoeffs() noexcept
+    {
+        for (auto& stage : coeffs) for (auto& sec : stage) sec = {};
+        if (numBands < 2) return;
+
+        const Filters x1 = butterworth(crossovers[0]);
+        setLane(0, 0, x1.lp, x1.lp);
+        setLane(0, 1, x1.hp, x1.hp);
+        if (numBands >= 3)
+        {
+            const Filters x2 = butterworth(crossovers[1]);
+            setLane(1, 0, x2.ap, identity);
+            setLane(1, 1, x2.lp, x2.lp);
+            setLane(1, 2, x2.hp, x2.hp);
+        }
+        if (numBands == 4)
+        {
+            const Filters x3 = butterworth(crossovers[2]);
+            setLane(2, 0, x3.ap, identity);
+            setLane(2, 1, x3.ap, identity);
+            setLane(2, 2, x3.lp, x3.lp);
+            setLane(2, 3, x3.hp, x3.hp);
+        }
+    }
+
+    struct Section { T b0[4], b1[4], b2[4], a1[4], a2[4]; };
+    struct SectionState { T s1[4], s2[4]; };
+
+    void setLane(int stage, int lane, const Biquad& first, const Biquad& second) noexcept
+    {
+        const Biquad* q[2] = { &first, &second };
+        for (int k = 0; k < 2; ++k)
+        {
+            Section& s = coeffs[(size_t) stage][(size_t) k];
+            s.b0[lane] = (T) (*q[k])[0]; s.b1[lane] = (T) (*q[k])[1]; s.b2[lane] = (T) (*q[k])[2];
+            s.a1[lane] = (T) (*q[k])[3]; s.a2[lane] = (T) (*q[k])[4];
+        }
+    }
+
+    template <int Stages, bool Ramp>
+    void run(T* d, int n, int ch, const float* pre, float preConst, const float* gain) noexcept
+    {
+        constexpr int numSections = 2 * Stages;
+        V b0[numSections], b1[numSections], b2[numSections], a1[numSections], a2[numSections];
+        V s1[numSections], s2[numSections];
+        auto& st = state[(size_t) ch];
+        for (int k = 0; k < numSections; ++k)
+        {
+            const Section& c = coeffs[(size_t) (k >> 1)][(size_t) (k & 1)];
+            b0[k] = V::load(c.b0); b1[k] = V::load(c.b1); b2[k] = V::load(c.b2);
+            a1[k] = V::load(c.a1); a2[k] = V::load(c.a2);
+            s1[k] = V::load(st[(size_t) k].s1); s2[k] = V::load(st[(size_t) k].s2);
+        }
+
+        // Transposed direct form II, one section per call.
+        auto biquad = [&](int k, V in)
+        {
+            const V y = b0[k] * in + s1[k];
+            s1[k] = b1[k] * in - a1[k] * y + s2[k];
+            s2[k] = b2[k] * in - a2[k] * y;
+            return y;
+        };
+
+        const V tf = V::load(tFrac);
+        V c = V::load(current.c), drive = V::load(current.drive), invKnee = V::load(current.invKnee);
+        V dc = V::set(0.0f), dDrive = dc, dInv = dc;
+        if constexpr (Ramp)
+        {
+            // invKnee is ramped linearly too rather than divided per sample;
+            // the curve stays continuous and ends exactly on the target.
+            const V step = V::set((T) 1 / (T) (n > 0 ? n : 1));
+            dc      = (V::load(target.c) - c) * step;
+            dDrive  = (V::load(target.drive) - drive) * step;
+            dInv    = (V::load(target.invKnee) - invKnee) * step;
+        }
+
+        T lanes[4];
+        for (int i = 0; i < n; ++i)
+        {
+            T x = d[i] * (T) (pre != nullptr ? pre[i] : preConst);
+            if (gain != nullptr) x *= (T) gain[i];
+
+            V v = biquad(1, biquad(0, V::set(x)));
+            if constexpr (Stages >= 2)
+            {
+                v.store(lanes);
+                const T in[4] = { lanes[0], lanes[1], lanes[1], 0 };
+                v = biquad(3, biquad(2, V::load(in)));
+            }
+            if constexpr (Stages >= 3)
+            {
+                v.store(lanes);
+                const T in[4] = { lanes[0], lanes[1], lanes[2], lanes[2] };
+                v = biquad(5, biquad(4, V::load(in)));
+            }
+
+            if constexpr (Ramp) { c = c + dc; drive = drive + dDrive; invKnee = invKnee + dInv; }
+            d[i] = softClipRoundedV(v * drive, c * tf, c, invKnee).sumLanes();
+        }
+
+        for (int k = 0; k < numSections; ++k)
+        {
+            s1[k].store(st[(size_t) k].s1);
+            s2[k].store(st[(size_t) k].s2);
+        }
+    }
+
+    struct BandValues
+    {
+        T c[4] { 1, 1, 1, 1 }, drive[4] { 1, 1, 1, 1 }, invKnee[4] { 1, 1, 1, 1 };
+        bool operator==(const BandValues& o) const noexcept
+        {
+            return std::equal(c, c + 4, o.c) && std::equal(drive, drive + 4, o.drive) && std::equal(invKnee, invKnee + 4, o.invKnee);
+        }
+    };
+
+    double sampleRate = 44100.0;
+    int numBands = 0, chunkLength = 0;
+    float crossovers[maxBands - 1] {}, targetCrossovers[maxBands - 1] {};
+    std::array<std::array<Section, 2>, numStages> coeffs {};
+    std::array<std::array<SectionState, 2 * numStages>, maxChannels> state {};
+    BandValues current, target;
+    T tFrac[4] { 1, 1, 1, 1 };
+};
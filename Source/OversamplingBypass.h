@@ -0,0 +1,131 @@
+#pragma once
+#include <juce_dsp/juce_dsp.h>
+
+// State for skipping the oversampler while the clipper is linear. Every
+// chunk's input and the clipper path's linear gain for it are kept in a
+// history ring, which doubles as the latency-matching delay line for
+// bypassed chunks and as the source for re-priming the oversampler's
+// filters before it takes over again. Only valid for linear-phase
+// oversampling, whose delay is the same at every frequency.
+template <typename T>
+class OversamplingBypass
+{
+public:
+    static constexpr int maxPrimeLength = 2048;
+
+    // History an oversampler with this latency needs to settle.
+    static int primeLengthFor(int latency) noexcept { return juce::jlimit(128, maxPrimeLength, 4 * latency + 128); }
+
+    void prepare(int numChannels, int maxBlock)
+    {
+        capacity = maxPrimeLength + 2 * maxBlock + 1024;
+        history.setSize(juce::jmax(1, numChannels), capacity, false, true, false);
+        gainHistory.setSize(juce::jmax(1, numChannels), capacity, false, true, false);
+        scratch.setSize(juce::jmax(1, numChannels), maxBlock, false, true, false);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        history.clear();
+        gainHistory.clear();
+        writePos = 0;
+        linearRun = 0;
+        bypassed = false;
+    }
+
+    // Appends one chunk of input with the linear gain of the clipper path
+    // for it, either per channel and sample (`gain[ch]`) or constant. Must be
+    // called before read() or prime() for that chunk.
+    void write(const juce::dsp::AudioBlock<T>& in, const float* const* gain, float constantGain) noexcept
+    {
+        const int n = (int) in.getNumSamples();
+        for (int ch = 0; ch < (int) in.getNumChannels(); ++ch)
+        {
+            const T* src = in.getChannelPointer((size_t) ch);
+            const float* g = gain[ch];
+            T* dst = history.getWritePointer(ch);
+            float* gdst = gainHistory.getWritePointer(ch);
+            for (int i = 0, p = writePos; i < n; ++i, p = (p + 1 == capacity ? 0 : p + 1))
+            {
+                dst[p]  = src[i];
+                gdst[p] = g != nullptr ? g[i] : constantGain;
+            }
+        }
+        writePos = (writePos + n) % capacity;
+        lastChunk = n;
+    }
+
+    // Bypass output for the chunk just written: its input delayed by
+    // `latency` samples, each sample scaled by the gain written with it.
+    void read(juce::dsp::AudioBlock<T>& out, int latency) const noexcept
+    {
+        const int n = (int) out.getNumSamples();
+        const int start = wrap(writePos - lastChunk - latency);
+        for (int ch = 0; ch < (int) out.getNumChannels(); ++ch)
+        {
+            const T* src = history.getReadPointer(ch);
+            const float* g = gainHistory.getReadPointer(ch);
+            T* dst = out.getChannelPointer((size_t) ch);
+            for (int i = 0, p = start; i < n; ++i, p = (p + 1 == capacity ? 0 : p + 1))
+                dst[i] = src[p] * (T) g[p];
+        }
+    }
+
+    // Runs the `length` samples preceding the chunk just written through the
+    // oversampler, applying their gains between up- and downsampling as the
+    // clipper path does, so both filters hold the state they would have had
+    // without the bypass. The output is dropped.
+    void prime(juce::dsp::Oversampling<T>& os, int length) noexcept
+    {
+        primeEndingAt(os, writePos - lastChunk, length);
+    }
+
+    // Same, through the end of the history, for an oversampler that takes
+    // over at the next chunk before it is written.
+    void primeToEnd(juce::dsp::Oversampling<T>& os, int length) noexcept
+    {
+        primeEndingAt(os, writePos, length);
+    }
+
+    int linearRun = 0;
+    bool bypassed = false;
+
+private:
+    void primeEndingAt(juce::dsp::Oversampling<T>& os, int end, int length) noexcept
+    {
+        const int numCh = history.getNumChannels();
+        const int factor = (int) os.getOversamplingFactor();
+        int pos = wrap(end - length);
+        os.reset();
+
+        for (int done = 0; done < length;)
+        {
+            const int n = juce::jmin(length - done, scratch.getNumSamples());
+            for (int ch = 0; ch < numCh; ++ch)
+            {
+                const T* src = history.getReadPointer(ch);
+                T* dst = scratch.getWritePointer(ch);
+                for (int i = 0, p = pos; i < n; ++i, p = (p + 1 == capacity ? 0 : p + 1)) dst[i] = src[p];
+            }
+            auto block = juce::dsp::AudioBlock<T>(scratch).getSubBlock(0, (size_t) n);
+            auto up = os.processSamplesUp(block);
+            for (int ch = 0; ch < numCh; ++ch)
+            {
+                const float* g = gainHistory.getReadPointer(ch);
+                T* d = up.getChannelPointer((size_t) ch);
+                for (int i = 0, p = pos; i < n; ++i, p = (p + 1 == capacity ? 0 : p + 1))
+                    for (int k = 0; k < factor; ++k) d[i * factor + k] *= (T) g[p];
+            }
+            os.processSamplesDown(block);
+            pos = (pos + n) % capacity;
+            done += n;
+        }
+    }
+
+    int wrap(int p) const noexcept { p %= capacity; return p < 0 ? p + capacity : p; }
+
+    juce::AudioBuffer<T> history, scratch;
+    juce::AudioBuffer<float> gainHistory;
+    int capacity = 1, writePos = 0, lastChunk = 0;
+};
@@ -24,13 +24,17 @@ static void label(Label& L, const String& t)
 
 ZClipAudioProcessorEditor::ZClipAudioProcessorEditor(ZClipAudioProcessor& proc)
     : AudioProcessorEditor(&proc), p(proc),
-      scope([&proc](AudioBuffer<float>& dest){ proc.readScope(dest); },
+      scope([&proc](ScopeFrame* dest, int maxFrames){ return proc.readScope(dest, maxFrames); },
             [&proc]{ return proc.getCeilingDb(); })
 {
     setOpaque(true);
-    setSize(980, 580);
+    setSize(980, 730);
 
     os.addItemList(StringArray{ "1x", "2x", "4x", "8x" }, 1);
+    osFilter.addItemList(StringArray{ "Linear Phase", "IIR", "IIR Low Latency" }, 1);
+    clipMode.addItemList(StringArray{ "Direct", "ADAA 1st Order", "ADAA 2nd Order" }, 1);
+    mbBands.addItemList(StringArray{ "Off", "2 Bands", "3 Bands", "4 Bands" }, 1);
+    renderOs.addItemList(StringArray{ "Off", "2x", "4x", "8x" }, 1);
 
     styleKnob(pregain); styleKnob(ceiling); styleKnob(drive); styleKnob(softness);
     styleKnob(upAmount); styleKnob(upKnee); styleKnob(mix); styleKnob(output);
@@ -45,6 +49,8 @@ ZClipAudioProcessorEditor::ZClipAudioProcessorEditor(ZClipAudioProcessor& proc)
     output.setRange(-24.0, 24.0, 0.01);
 
     label(lOS, "Oversampling");
+    label(lOSFilter, "OS Filter");
+    label(lClipMode, "Clip Mode");
     label(lPre, "PreGain");
     label(lCeil, "Ceiling (dB)");
     label(lDrive, "Drive");
@@ -54,12 +60,18 @@ ZClipAudioProcessorEditor::ZClipAudioProcessorEditor(ZClipAudioProcessor& proc)
     label(lUpKnee, "Upward Knee (dB)");
     label(lMix, "Mix (%)");
     label(lOut, "Output");
+    label(lMbBands, "Multiband");
+    label(lRenderOs, "Render OS");
 
     addAndMakeVisible(lOS);   addAndMakeVisible(os);
+    addAndMakeVisible(lOSFilter); addAndMakeVisible(osFilter);
+    addAndMakeVisible(lClipMode); addAndMakeVisible(clipMode);
 
     addAndMakeVisible(automakeup);
     addAndMakeVisible(isp);
     addAndMakeVisible(upEnable);
+    addAndMakeVisible(upLink);
+    addAndMakeVisible(osAdaptive);
 
     addAndMakeVisible(lPre);    addAndMakeVisible(pregain);
     addAndMakeVisible(lCeil);   addAndMakeVisible(ceiling);
@@ -70,12 +82,64 @@ ZClipAudioProcessorEditor::ZClipAudioProcessorEditor(ZClipAudioProcessor& proc)
     addAndMakeVisible(lMix);    addAndMakeVisible(mix);
     addAndMakeVisible(lOut);    addAndMakeVisible(output);
 
+    addAndMakeVisible(lMbBands); addAndMakeVisible(mbBands);
+    addAndMakeVisible(lRenderOs); addAndMakeVisible(renderOs);
+    for (int i = 0; i < numMbKnobs; ++i)
+    {
+        const bool xover = i < maxBands - 1;
+        const int band = (i - (maxBands - 1)) / 3 + 1, kind = (i - (maxBands - 1)) % 3;
+        const String id   = xover ? "mb_xover" + String(i + 1)
+                                  : StringArray{ "mb_ceiling", "mb_shape", "mb_drive" }[kind] + String(band);
+        const String name = xover ? "X-Over " + String(i + 1)
+                                  : "B" + String(band) + " " + StringArray{ "Ceil", "Shape", "Drive" }[kind];
+
+        auto& k = mbKnobs[(size_t) i];
+        styleKnob(k);
+        k.setTextBoxStyle(Slider::TextBoxBelow, false, 50, 16);
+        label(mbLabels[(size_t) i], name);
+        mbLabels[(size_t) i].setFont(Font(12.0f));
+        addAndMakeVisible(mbLabels[(size_t) i]);
+        addAndMakeVisible(k);
+        aMbKnobs[(size_t) i] = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(p.apvts, id, k);
+    }
+
     addAndMakeVisible(scope);
 
+    meterReadout.setJustificationType(Justification::centredLeft);
+    meterReadout.setColour(Label::textColourId, Colours::white.withAlpha(0.9f));
+    meterReadout.setFont(Font(13.0f));
+    addAndMakeVisible(meterReadout);
+    meterReset.onClick = [this] { p.resetMeters(); };
+    addAndMakeVisible(meterReset);
+
+   #if ZCLIP_PROFILE
+    profileOverlay.setJustificationType(Justification::topLeft);
+    profileOverlay.setColour(Label::textColourId, Colours::white);
+    profileOverlay.setColour(Label::backgroundColourId, Colours::black.withAlpha(0.6f));
+    profileOverlay.setFont(Font(Font::getDefaultMonospacedFontName(), 12.0f, Font::plain));
+    profileOverlay.setInterceptsMouseClicks(false, false);
+    addAndMakeVisible(profileOverlay);
+    profileDump.onClick = [this]
+    {
+        const auto file = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("ZClip")
+                              .getChildFile("profile-" + Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".txt");
+        lastDump = profileStats.dump(file, p.getProfileDropped()) ? "saved " + file.getFullPathName()
+                                                                  : "cannot write " + file.getFullPathName();
+    };
+    addAndMakeVisible(profileDump);
+   #endif
+    startTimerHz(10);
+
     aOS    = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(p.apvts, "os", os);
+    aOSFilter = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(p.apvts, "os_filter", osFilter);
+    aClipMode = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(p.apvts, "clip_mode", clipMode);
+    aMbBands  = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(p.apvts, "mb_bands", mbBands);
+    aRenderOs = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(p.apvts, "render_os", renderOs);
     aAM    = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(p.apvts, "automakeup", automakeup);
     aISP   = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(p.apvts, "isp", isp);
     aUpEn  = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(p.apvts, "up_enable", upEnable);
+    aUpLink= std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(p.apvts, "up_link", upLink);
+    aOSAdaptive = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(p.apvts, "os_adaptive", osAdaptive);
 
     aPre   = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(p.apvts, "pregain", pregain);
     aCeil  = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(p.apvts, "ceiling", ceiling);
@@ -89,11 +153,35 @@ ZClipAudioProcessorEditor::ZClipAudioProcessorEditor(ZClipAudioProcessor& proc)
 
 ZClipAudioProcessorEditor::~ZClipAudioProcessorEditor() {}
 
+void ZClipAudioProcessorEditor::timerCallback()
+{
+    // Greyed out while the other settings leave it without effect.
+    osAdaptive.setEnabled(p.isAdaptiveOsAvailable());
+
+    MeterSnapshot m;
+    p.readMeters(m);
+
+    auto db = [](float v, int places) { return v <= MeterSnapshot::floorDb ? String("-inf") : String(v, places); };
+    const double clipPct = m.consideredSamples > 0 ? 100.0 * (double) m.clippedSamples / (double) m.consideredSamples : 0.0;
+    meterReadout.setText("TP " + db(m.truePeakDb, 1) + " (max " + db(m.truePeakHoldDb, 1) + ") dBTP   GR " + String(m.maxGainReductionDb, 1)
+                         + " dB   Clip " + String(clipPct, 2) + "%\n"
+                         + "M " + db(m.momentaryLufs, 1) + "   S " + db(m.shortTermLufs, 1) + "   I " + db(m.integratedLufs, 1) + " LUFS",
+                         dontSendNotification);
+
+   #if ZCLIP_PROFILE
+    ProfileRecord records[256];
+    for (int n; (n = p.readProfile(records, 256)) > 0;)
+        for (int i = 0; i < n; ++i) profileStats.add(records[i]);
+    profileOverlay.setText(profileStats.describe(p.getProfileDropped()) + lastDump, dontSendNotification);
+   #endif
+}
+
 void ZClipAudioProcessorEditor::paint(Graphics& g)
 {
-    Image bg = ImageCache::getFromFile(File("C:/ZClip/Assets/background.png"));
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const Image bg = assets->getBackground(getWidth(), getHeight(), scale);
     if (bg.isValid())
-        g.drawImageWithin(bg, 0, 0, getWidth(), getHeight(), RectanglePlacement::stretchToFit);
+        g.drawImage(bg, getLocalBounds().toFloat(), RectanglePlacement::stretchToFit);
     else
         g.fillAll(Colour::fromFloatRGBA(0.07f, 0.08f, 0.10f, 1.0f));
 
@@ -113,9 +201,15 @@ void ZClipAudioProcessorEditor::resized()
     auto r = getLocalBounds().reduced(24);
 
     auto top = r.removeFromTop(64);
-    const int colW = 240;
-    Rectangle<int> osRect(top.getCentreX() - colW/2, top.getY()+10, colW, 48);
-    placeLabelAndCtrl(lOS, os, osRect);
+    meterReset.setBounds(top.removeFromRight(100).withTrimmedTop(20).withHeight(26));
+    top.removeFromRight(12);
+    placeLabelAndCtrl(lClipMode, clipMode, top.removeFromRight(160).withTrimmedTop(10).withHeight(48));
+    top.removeFromRight(12);
+    placeLabelAndCtrl(lOSFilter, osFilter, top.removeFromRight(160).withTrimmedTop(10).withHeight(48));
+    top.removeFromRight(12);
+    placeLabelAndCtrl(lOS, os, top.removeFromRight(110).withTrimmedTop(10).withHeight(48));
+    top.removeFromRight(12);
+    meterReadout.setBounds(top.withTrimmedTop(10).withHeight(44));
 
     auto toggles = r.removeFromTop(32);
     automakeup.setBounds(toggles.removeFromLeft(170));
@@ -123,12 +217,20 @@ void ZClipAudioProcessorEditor::resized()
     isp.setBounds(toggles.removeFromLeft(200));
     toggles.removeFromLeft(12);
     upEnable.setBounds(toggles.removeFromLeft(200));
+    toggles.removeFromLeft(12);
+    upLink.setBounds(toggles.removeFromLeft(150));
+    toggles.removeFromLeft(12);
+    osAdaptive.setBounds(toggles.removeFromLeft(150));
     r.removeFromTop(6);
 
     const int scopeH = 200;
     const int scopeY = r.getY();
     r.removeFromTop(scopeH);
     scope.setBounds(16, scopeY, getWidth()-32, scopeH);
+   #if ZCLIP_PROFILE
+    profileOverlay.setBounds(scope.getBounds().withWidth(600));
+    profileDump.setBounds(scope.getRight() - 110, scope.getY() + 6, 100, 22);
+   #endif
 
     r.removeFromTop(16);
 
@@ -148,4 +250,17 @@ void ZClipAudioProcessorEditor::resized()
     placeLabelAndCtrl(lUpKnee, upKnee,   slot(5));
     placeLabelAndCtrl(lMix,    mix,      slot(6));
     placeLabelAndCtrl(lOut,    output,   slot(7));
+
+    r.removeFromTop(8);
+    auto bands = r.removeFromTop(120);
+    auto bandsLeft = bands.removeFromLeft(110);
+    placeLabelAndCtrl(lMbBands, mbBands, bandsLeft.removeFromTop(48));
+    bandsLeft.removeFromTop(12);
+    placeLabelAndCtrl(lRenderOs, renderOs, bandsLeft.removeFromTop(48));
+    bands.removeFromLeft(12);
+    const int mbGap = 4;
+    const int mbW = (bands.getWidth() - mbGap * (numMbKnobs - 1)) / numMbKnobs;
+    for (int i = 0; i < numMbKnobs; ++i)
+        placeLabelAndCtrl(mbLabels[(size_t) i], mbKnobs[(size_t) i],
+                          Rectangle<int>(bands.getX() + i * (mbW + mbGap), bands.getY(), mbW, bands.getHeight()));
 }
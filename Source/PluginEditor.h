@@ -2,8 +2,9 @@
 #include <juce_gui_extra/juce_gui_extra.h>
 #include "PluginProcessor.h"
 #include "ScopeComponent.h"
+#include "SharedAssets.h"
 
-class ZClipAudioProcessorEditor : public juce::AudioProcessorEditor
+class ZClipAudioProcessorEditor : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     ZClipAudioProcessorEditor(ZClipAudioProcessor&);
@@ -12,18 +13,38 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+
     ZClipAudioProcessor& p;
+    juce::SharedResourcePointer<SharedAssets> assets;
+
+    // Crossovers, then ceiling/shape/drive for each band.
+    static constexpr int numMbKnobs = (maxBands - 1) + 3 * maxBands;
 
-    juce::ComboBox os;
-    juce::ToggleButton automakeup{"AutoMakeup"}, isp{"TruePeakProtect"}, upEnable{"Upward Compression"};
+    juce::ComboBox os, osFilter, clipMode, mbBands, renderOs;
+    juce::ToggleButton automakeup{"AutoMakeup"}, isp{"TruePeakProtect"}, upEnable{"Upward Compression"}, upLink{"Link Channels"}, osAdaptive{"Adaptive OS"};
     juce::Slider pregain, ceiling, drive, softness, upAmount, upKnee, mix, output;
-    juce::Label  lOS, lPre, lCeil, lDrive, lSoft, lUpEn, lUpAmt, lUpKnee, lMix, lOut;
+    juce::Label  lOS, lOSFilter, lClipMode, lMbBands, lRenderOs, lPre, lCeil, lDrive, lSoft, lUpEn, lUpAmt, lUpKnee, lMix, lOut;
 
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> aOS;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> aAM, aISP, aUpEn;
+    std::array<juce::Slider, numMbKnobs> mbKnobs;
+    std::array<juce::Label, numMbKnobs> mbLabels;
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> aOS, aOSFilter, aClipMode, aMbBands, aRenderOs;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> aAM, aISP, aUpEn, aUpLink, aOSAdaptive;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> aPre, aCeil, aDrive, aSoft, aUpAmt, aUpKnee, aMix, aOut;
+    std::array<std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>, numMbKnobs> aMbKnobs;
 
     ScopeComponent scope;
+    juce::Label meterReadout;
+    juce::TextButton meterReset{"Reset Meters"};
+
+   #if ZCLIP_PROFILE
+    // Stage timings drawn over the scope, and a button that writes them out.
+    ProfileStats profileStats;
+    juce::Label profileOverlay;
+    juce::TextButton profileDump{"Dump Profile"};
+    juce::String lastDump;
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ZClipAudioProcessorEditor)
 };
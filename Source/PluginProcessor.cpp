@@ -13,21 +13,96 @@ ZClipAudioProcessor::ZClipAudioProcessor()
       .withOutput("Output", AudioChannelSet::stereo(), true)
   ),
   apvts(*this, nullptr, "PARAMS", createLayout())
-{}
+{
+    params.pregain    = apvts.getRawParameterValue("pregain");
+    params.ceiling    = apvts.getRawParameterValue("ceiling");
+    params.automakeup = apvts.getRawParameterValue("automakeup");
+    params.upEnable   = apvts.getRawParameterValue("up_enable");
+    params.upAmount   = apvts.getRawParameterValue("up_amount");
+    params.upKnee     = apvts.getRawParameterValue("up_knee");
+    params.mix        = apvts.getRawParameterValue("mix");
+    params.output     = apvts.getRawParameterValue("output");
+    params.os         = apvts.getRawParameterValue("os");
+    params.isp        = apvts.getRawParameterValue("isp");
+    params.drive      = apvts.getRawParameterValue("drive");
+    params.shape      = apvts.getRawParameterValue("shape");
+    params.upLink     = apvts.getRawParameterValue("up_link");
+    params.osFilter   = apvts.getRawParameterValue("os_filter");
+    params.osAdaptive = apvts.getRawParameterValue("os_adaptive");
+    params.clipMode   = apvts.getRawParameterValue("clip_mode");
+    params.renderOs   = apvts.getRawParameterValue("render_os");
+    params.mbBands    = apvts.getRawParameterValue("mb_bands");
+    for (int k = 0; k < maxBands - 1; ++k)
+        params.mbXover[(size_t) k] = apvts.getRawParameterValue("mb_xover" + String(k + 1));
+    for (int b = 0; b < maxBands; ++b)
+    {
+        params.mbCeiling[(size_t) b] = apvts.getRawParameterValue("mb_ceiling" + String(b + 1));
+        params.mbShape[(size_t) b]   = apvts.getRawParameterValue("mb_shape" + String(b + 1));
+        params.mbDrive[(size_t) b]   = apvts.getRawParameterValue("mb_drive" + String(b + 1));
+    }
+}
 
-void ZClipAudioProcessor::prepareToPlay(double sr, int samplesPerBlock)
+void ZClipAudioProcessor::prepareToPlay(double sr, int)
 {
     sampleRate = sr;
     envAttack = 0.001f;
     envRelease = 0.050f;
-    currentOSChoice = (int) apvts.getRawParameterValue("os")->load();
-    currentMaxBlock = (size_t) jmax(1, samplesPerBlock);
-
-    ensureOversampler(currentOSChoice, getTotalNumInputChannels(), currentMaxBlock);
-    if (oversampler) { oversampler->reset(); oversampler->initProcessing(currentMaxBlock); }
+    selectOversampling(currentOSChoice, currentOSEngine, isNonRealtime());
+    selectOversampling(altOSChoice, altOSEngine, ! isNonRealtime());
+    currentClipMode = jlimit(0, numClipModes - 1, (int) params.clipMode->load());
+    chunkSize = (size_t) subBlockSize;
+    jassert(getTotalNumInputChannels() <= UpwardDetector::maxChannels);
 
-    scopeBuffer.clear();
-    scopeFifo.reset();
+    if (isUsingDoublePrecision())
+    {
+        doubleEngine.prepare(sr, getTotalNumInputChannels(), chunkSize);
+        floatEngine.release();
+    }
+    else
+    {
+        floatEngine.prepare(sr, getTotalNumInputChannels(), chunkSize);
+        doubleEngine.release();
+    }
+    upGainBuffer.setSize(jmax(1, getTotalNumInputChannels()), (int) chunkSize, false, true, false);
+    upGainOsBuffer.setSize(jmax(1, getTotalNumInputChannels()), (int) chunkSize * 8, false, true, false);
+    bypassGainBuffer.setSize(jmax(1, getTotalNumInputChannels()), (int) chunkSize, false, true, false);
+    rampBuffer.setSize(ClipRamps::numRamps, (int) chunkSize, false, true, false);
+    osRampBuffer.setSize(ClipRamps::numRamps, (int) chunkSize * 8, false, true, false);
+    for (auto& sm : clipSmooth) sm.reset(sr, smoothingSeconds);
+    outSmooth.reset(sr, smoothingSeconds);
+    snapSmoothing = true;
+    updateDetector();
+    updateLatency();
+    upEnv.fill(0.0f);
+    upGainPrev.fill(1.0f);
+    adaaState.fill({});
+    silentRun = 0;
+    asleep = false;
+
+    const int mbChoice = jlimit(0, maxBands - 1, (int) params.mbBands->load());
+    currentBands = mbChoice > 0 ? mbChoice + 1 : 0;
+    unityRamp.allocate(chunkSize * 8, false);
+    FloatVectorOperations::fill(unityRamp.get(), 1.0f, (int) chunkSize * 8);
+
+    scopeFeed.prepare(sr);
+
+    // BS.1770 channel weights: LFE is ignored, surrounds count +1.5 dB.
+    std::vector<float> weights;
+    const auto layout = getChannelLayoutOfBus(false, 0);
+    for (int ch = 0; ch < getTotalNumOutputChannels(); ++ch)
+    {
+        const auto type = layout.getTypeOfChannel(ch);
+        if (type == AudioChannelSet::LFE || type == AudioChannelSet::LFE2)
+            weights.push_back(0.0f);
+        else if (type == AudioChannelSet::leftSurround || type == AudioChannelSet::rightSurround
+              || type == AudioChannelSet::leftSurroundSide || type == AudioChannelSet::rightSurroundSide
+              || type == AudioChannelSet::leftSurroundRear || type == AudioChannelSet::rightSurroundRear)
+            weights.push_back(1.41f);
+        else
+            weights.push_back(1.0f);
+    }
+    meters.prepare(sr, weights);
+    meterResetPending.store(false);
     recentClipRatio.store(0.0f);
 }
 
@@ -36,197 +111,678 @@ void ZClipAudioProcessor::releaseResources(){}
 bool ZClipAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
     const bool same = layouts.getMainInputChannelSet() == layouts.getMainOutputChannelSet();
-    const bool okOut = layouts.getMainOutputChannelSet() == AudioChannelSet::mono()
-                    || layouts.getMainOutputChannelSet() == AudioChannelSet::stereo();
-    return same && okOut;
+    const auto out   = layouts.getMainOutputChannelSet();
+    const bool okOut = out == AudioChannelSet::mono()
+                    || out == AudioChannelSet::stereo()
+                    || out == AudioChannelSet::create5point1()
+                    || out == AudioChannelSet::create7point1()
+                    || out == AudioChannelSet::create7point1point4();
+    return same && okOut && out.size() <= UpwardDetector::maxChannels;
 }
 
-static inline float softClipRounded(float x, float ceiling, float softness, float driveLin)
+template <bool HasGain, bool Blend, int Mode, typename T>
+int ZClipAudioProcessor::clipChannel(T* d, int n, const ClipParams& clip, const float* const* r, const float* gain, int ch) noexcept
 {
-    const float c = jmax(1.0e-6f, ceiling);
-    const float s = jlimit(0.0f, 1.0f, softness);
-    const float w = 0.6f * s;
-    const float t = c * (1.0f - w);
-
-    const float u = x * driveLin;
-    const float a = std::abs(u);
-    const float sg = (u < 0.0f) ? -1.0f : 1.0f;
-
-    if (a <= t) return u;
-    if (a >= c) return sg * c;
-
-    const float v = (a - t) / (c - t);
-    const float H = (-v*v*v + v*v + v);
-    return sg * (t + (c - t) * H);
+    if constexpr (Mode == clipDirect)
+        return (r != nullptr) ? clipBlockRamped<HasGain, Blend>(d, n, clip, r, gain)
+                              : clipBlock<HasGain, Blend>(d, n, clip, gain);
+    else
+        return clipBlockAdaa<Mode, HasGain, Blend>(d, n, clip, r, gain, adaaState[(size_t) ch]);
 }
 
-void ZClipAudioProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer&)
+template <typename T, bool Up, bool Blend, int OsPow, int Mode>
+int ZClipAudioProcessor::processPath(dsp::AudioBlock<T> block, Oversampler<T>* oversampler, const ClipParams& clip, const ClipRamps* ramps)
 {
-    ScopedNoDenormals _;
-    const int totalCh    = getTotalNumInputChannels();
-    const int numSamples = buffer.getNumSamples();
+    auto& eng = engineFor<T>();
+    const int totalCh    = (int) block.getNumChannels();
+    const int numSamples = (int) block.getNumSamples();
+    int clipped = 0;
+
+    const float* const* r = nullptr;
+    const float* osRamps[ClipRamps::numRamps] = {};
+    if (ramps != nullptr)
+    {
+        r = ramps->data;
+        if constexpr (OsPow > 0)
+        {
+            for (int k = 0; k < ClipRamps::numRamps; ++k)
+            {
+                expandRamp(osRampBuffer.getWritePointer(k), ramps->data[k], ramps->start[k], numSamples, 1 << OsPow);
+                osRamps[k] = osRampBuffer.getReadPointer(k);
+            }
+            r = osRamps;
+        }
+    }
 
-    const int osChoiceNow = (int) apvts.getRawParameterValue("os")->load();
-    if (osChoiceNow != currentOSChoice || !oversampler || (size_t) numSamples > currentMaxBlock)
+    // With multiband on, the bands take over pregain and upward gain and
+    // the wideband stage after them applies drive and the ceiling, so it
+    // runs with unity pregain and mix; the dry blend comes last.
+    auto& mb = eng.mbOutgoing != nullptr ? *eng.mbOutgoing : eng.multiband[(size_t) OsPow];
+    const bool split = mb.getNumBands() > 1;
+    ClipParams wide = clip;
+    wide.pre = wide.mix = 1.0f;
+    const float* wideRamps[ClipRamps::numRamps] = {};
+    if (split && r != nullptr)
     {
-        currentOSChoice = osChoiceNow;
-        currentMaxBlock = (size_t) jmax<int>((int) currentMaxBlock, numSamples);
-        ensureOversampler(currentOSChoice, totalCh, currentMaxBlock);
-        if (oversampler) { oversampler->reset(); oversampler->initProcessing(currentMaxBlock); }
+        wideRamps[ClipRamps::pre]   = wideRamps[ClipRamps::mix] = unityRamp.get();
+        wideRamps[ClipRamps::ceil]  = r[ClipRamps::ceil];
+        wideRamps[ClipRamps::drive] = r[ClipRamps::drive];
     }
 
-    const float pre      =          dbToLin(apvts.getRawParameterValue("pregain")->load());
-    const float ceilLin  = jlimit(0.01f, 1.0f, dbToLin(apvts.getRawParameterValue("ceiling")->load()));
-    const float out      =          dbToLin(apvts.getRawParameterValue("output")->load());
-    const float mix      =          apvts.getRawParameterValue("mix")->load() * 0.01f;
-    const bool  autoMk   =          apvts.getRawParameterValue("automakeup")->load() > 0.5f;
+    // Upward gains arrive at the base rate and are interpolated up to the
+    // clipping rate. They run ahead of the upsampled signal by the
+    // upsampling filter's delay, a fraction of the attack time.
+    const float* upGain[UpwardDetector::maxChannels] = {};
+    if constexpr (Up)
+    {
+        const HotPathProfiler::Scope timed(profiler, ProfileRecord::detect);
+        const int gainCh = upLinked ? 1 : totalCh;
+        for (int ch = 0; ch < gainCh; ++ch)
+        {
+            if constexpr (OsPow > 0)
+            {
+                expandRamp(upGainOsBuffer.getWritePointer(ch), upGainBuffer.getReadPointer(ch), upGainStart[(size_t) ch], numSamples, 1 << OsPow);
+                upGain[ch] = upGainOsBuffer.getReadPointer(ch);
+            }
+            else upGain[ch] = upGainBuffer.getReadPointer(ch);
+        }
+        for (int ch = gainCh; ch < totalCh; ++ch) upGain[ch] = upGain[0];
+    }
 
-    const bool  upOn     =          apvts.getRawParameterValue("up_enable")->load() > 0.5f;
-    const float upDb     =          apvts.getRawParameterValue("up_amount")->load();
-    const float upMax    =          dbToLin(upDb);
-    const float upKnee   = jlimit(0.0f, 12.0f, apvts.getRawParameterValue("up_knee")->load());
+    auto shape = [&](const dsp::AudioBlock<T>& b, int ns)
+    {
+        const HotPathProfiler::Scope timed(profiler, ProfileRecord::shape);
+        for (int ch = 0; ch < totalCh; ++ch)
+        {
+            T* d = b.getChannelPointer((size_t) ch);
+            const float* gain = upGain[ch];
+            if (! split)
+            {
+                clipped += clipChannel<Up, Blend, Mode>(d, ns, clip, r, gain, ch);
+                continue;
+            }
 
-    const bool  ispProtect =       apvts.getRawParameterValue("isp")->load() > 0.5f;
-    const float driveDb  =          apvts.getRawParameterValue("drive")->load();
-    const float driveLin =          dbToLin(driveDb);
+            T* dry = eng.mbDryBuffer.getWritePointer(ch);
+            if constexpr (Blend) FloatVectorOperations::copy(dry, d, ns);
+            mb.process(d, ns, ch, r != nullptr ? r[ClipRamps::pre] : nullptr, clip.pre, gain);
+            clipped += clipChannel<false, false, Mode>(d, ns, wide, r != nullptr ? wideRamps : nullptr, nullptr, ch);
+            if constexpr (Blend) blendDry<Mode>(d, dry, ns, clip, r, adaaState[(size_t) ch].dry1);
+        }
+        if (split) mb.finishChunk();
+    };
 
-    const float makeup = autoMk ? (1.0f / std::sqrt(jmax(ceilLin, 1.0e-6f))) : 1.0f;
+    if constexpr (OsPow > 0)
+    {
+        auto& os = *oversampler;
+        dsp::AudioBlock<T> up;
+        {
+            const HotPathProfiler::Scope timed(profiler, ProfileRecord::upsample);
+            up = os.processSamplesUp(block);
+        }
+        shape(up, numSamples << OsPow);
+        const HotPathProfiler::Scope timed(profiler, ProfileRecord::downsample);
+        os.processSamplesDown(block);
+    }
+    else
+    {
+        shape(block, numSamples);
+    }
+    return clipped;
+}
 
-    dsp::AudioBlock<float> block(buffer);
-    int clippedCount = 0, considered = 0;
-    const int osFactor = 1 << currentOSChoice;
-	
-	const float softness = apvts.getRawParameterValue("shape")->load();
+// Upward detection at the base rate, ahead of upsampling, so its cost and
+// time constants don't depend on the oversampling factor. The detectors
+// step one frame at a time across all channels, so the per-channel
+// envelopes in upEnv sit side by side in the lanes. Linked, one envelope
+// follows the loudest channel and channel 0 of upGainBuffer carries the
+// shared gain.
+template <typename T>
+void ZClipAudioProcessor::detectUpward(const dsp::AudioBlock<T>& b, const ClipParams& clip, const ClipRamps* ramps) noexcept
+{
+    const HotPathProfiler::Scope timed(profiler, ProfileRecord::detect);
+    const int totalCh = (int) b.getNumChannels();
+    const int ns      = (int) b.getNumSamples();
+    const T* src[UpwardDetector::maxChannels];
+    float* dst[UpwardDetector::maxChannels];
+    for (int ch = 0; ch < totalCh; ++ch)
+    {
+        src[ch] = b.getChannelPointer((size_t) ch);
+        dst[ch] = upGainBuffer.getWritePointer(ch);
+    }
+
+    float ax[UpwardDetector::maxChannels], g[UpwardDetector::maxChannels];
+    for (int i = 0; i < ns; ++i)
+    {
+        const float p = (ramps != nullptr) ? ramps->data[ClipRamps::pre][i] : clip.pre;
+        for (int ch = 0; ch < totalCh; ++ch) ax[ch] = (float) std::abs(src[ch][i] * (T) p);
+
+        if (upLinked)
+        {
+            float peak = ax[0];
+            for (int ch = 1; ch < totalCh; ++ch) peak = ax[ch] > peak ? ax[ch] : peak;
+            upDetector.processFrame(&peak, upEnv.data(), g, 1);
+            dst[0][i] = g[0];
+        }
+        else
+        {
+            upDetector.processFrame(ax, upEnv.data(), g, totalCh);
+            for (int ch = 0; ch < totalCh; ++ch) dst[ch][i] = g[ch];
+        }
+    }
+
+    upGainStart = upGainPrev;
+    for (int ch = 0; ch < (upLinked ? 1 : totalCh) && ns > 0; ++ch) upGainPrev[(size_t) ch] = dst[ch][ns - 1];
+}
 
-    auto processSample = [&](float x, float dry, int ch)->float
+// Runs one chunk either through `path` or, while the clipper stays linear,
+// through a delay matching the oversampler's latency. The bypass is entered
+// only after enough linear input that both routes carry the same signal,
+// and left as soon as a chunk may reach the knee: the oversampler is then
+// re-primed from the input history, and the first `latency` output samples,
+// which still come from linear input, fade from the delay to the oversampler.
+template <typename T>
+int ZClipAudioProcessor::processAdaptive(dsp::AudioBlock<T> sub, PathFn<T> path, Oversampler<T>* os,
+                                         const ClipParams& clip, const ClipRamps* ramps, bool allowBypass, bool up)
+{
+    auto& osBypass = engineFor<T>().osBypass;
+    const int totalCh = (int) sub.getNumChannels();
+    const int len     = (int) sub.getNumSamples();
+    const int latency = roundToInt(os->getLatencyInSamples());
+    const int primeLength = OversamplingBypass<T>::primeLengthFor(latency);
+    const int hold = jmax(primeLength + (int) chunkSize, roundToInt(0.05 * sampleRate));
+
+    // Linear gain of the clipper path below the knee, per channel when the
+    // upward gains differ, and the worst case drive into the knee and
+    // output level against the ceiling.
+    const float* gain[UpwardDetector::maxChannels] = {};
+    float constGain = clip.mix * clip.pre * clip.drive + (1.0f - clip.mix);
+    float maxDrive = clip.pre * clip.drive, minKnee = clip.t, minCeil = clip.c, maxGain = std::abs(constGain);
+    if (ramps != nullptr || up)
     {
-        if (upOn)
+        const float* const* r = ramps != nullptr ? ramps->data : nullptr;
+        const int gainCh = up && ! upLinked ? totalCh : 1;
+        for (int ch = 0; ch < gainCh; ++ch)
         {
-            float& env = (ch == 0 ? levelEnvL : levelEnvR);
-            const float ax   = std::abs(x);
-            const float rateMul = (currentOSChoice > 0 ? 0.5f * (float) osFactor : 1.0f);
-            const float atk  = std::exp(-1.0f / (rateMul * (float) sampleRate * envAttack));
-            const float rel  = std::exp(-1.0f / (rateMul * (float) sampleRate * envRelease));
-            env = (ax > env) ? (atk * env + (1.0f - atk) * ax)
-                             : (rel * env + (1.0f - rel) * ax);
-
-            const float envForDB = jmax(env, 1.0e-9f);
-            const float envDB = 20.0f * std::log10(envForDB / ceilLin);
-            float comp = 0.0f;
-            if (envDB < 0.0f)
+            const float* g = up ? upGainBuffer.getReadPointer(ch) : nullptr;
+            float* dst = bypassGainBuffer.getWritePointer(ch);
+            for (int i = 0; i < len; ++i)
             {
-                if (upKnee > 0.0f && envDB > -upKnee) comp = (upMax - 1.0f) * ((0.0f - envDB) / upKnee);
-                else                                   comp = (upMax - 1.0f);
+                const float m = r != nullptr ? r[ClipRamps::mix][i] : clip.mix;
+                const float d = (r != nullptr ? r[ClipRamps::pre][i] * r[ClipRamps::drive][i] : clip.pre * clip.drive)
+                              * (g != nullptr ? g[i] : 1.0f);
+                const float c = r != nullptr ? jmax(r[ClipRamps::ceil][i], 1.0e-6f) : clip.c;
+                dst[i] = m * d + (1.0f - m);
+                maxDrive = jmax(maxDrive, d);
+                minCeil  = jmin(minCeil, c);
+                minKnee  = jmin(minKnee, c * clip.tFrac);
+                maxGain  = jmax(maxGain, std::abs(dst[i]));
             }
-            x *= (1.0f + comp);
+            gain[ch] = dst;
         }
+        for (int ch = gainCh; ch < totalCh; ++ch) gain[ch] = gain[0];
+    }
+    osBypass.write(sub, gain, constGain);
 
-		const float y = softClipRounded(x, ceilLin, softness, driveLin);
-		
-        float m = mix * y + (1.0f - mix) * dry;
-        considered++;
-        if (std::abs(m) > ceilLin) clippedCount++;
-        return jlimit(-ceilLin, ceilLin, m);
-    };
-
-    if (oversampler && currentOSChoice > 0)
+    float peak = 0.0f;
+    for (int ch = 0; ch < totalCh; ++ch)
     {
-        auto& os = *oversampler;
-        auto up  = os.processSamplesUp(block);
+        const auto range = FloatVectorOperations::findMinAndMax(sub.getChannelPointer((size_t) ch), len);
+        peak = jmax(peak, (float) -range.getStart(), (float) range.getEnd());
+    }
+    const bool linear = allowBypass && peak * maxDrive < minKnee * bypassHeadroom
+                                    && peak * maxGain  < minCeil * bypassHeadroom;
+    osBypass.linearRun = linear ? osBypass.linearRun + len : 0;
 
+    auto held = dsp::AudioBlock<T>(engineFor<T>().xfadeBuffer).getSubsetChannelBlock(0, (size_t) totalCh)
+                                                  .getSubBlock(0, (size_t) len);
+    auto fade = [&](int n, bool toHeld)
+    {
+        const float step = 1.0f / (float) jmax(1, n);
         for (int ch = 0; ch < totalCh; ++ch)
         {
-            float* d = up.getChannelPointer(ch);
-            const int ns  = (int) up.getNumSamples();
-            for (int i = 0; i < ns; ++i)
+            T* d = sub.getChannelPointer((size_t) ch);
+            const T* h = held.getChannelPointer((size_t) ch);
+            for (int i = 0; i < n; ++i)
             {
-                const float dry = d[i];
-                const float x   = dry * pre * makeup;
-                d[i] = processSample(x, dry, ch);
+                const T w = (T) (i + 1) * (T) step;
+                d[i] = toHeld ? d[i] + w * (h[i] - d[i]) : h[i] + w * (d[i] - h[i]);
             }
-            if (ispProtect)
-                for (int i = 0; i < ns; ++i) d[i] = jlimit(-ceilLin, ceilLin, d[i]);
+            if (toHeld) for (int i = n; i < len; ++i) d[i] = h[i];
         }
+    };
 
-        os.processSamplesDown(block);
+    if (osBypass.bypassed)
+    {
+        if (linear)
+        {
+            osBypass.read(sub, latency);
+            return 0;
+        }
 
-        if (ispProtect)
-            for (int ch = 0; ch < totalCh; ++ch)
+        osBypass.read(held, latency);
+        osBypass.prime(*os, primeLength);
+        osBypass.bypassed = false;
+        const int clipped = (this->*path)(sub, os, clip, ramps);
+        fade(jmin(len, latency), false);
+        return clipped;
+    }
+
+    const int clipped = (this->*path)(sub, os, clip, ramps);
+    if (linear && osBypass.linearRun >= hold)
+    {
+        osBypass.read(held, latency);
+        fade(len, true);
+        osBypass.bypassed = true;
+    }
+    return clipped;
+}
+
+template <typename T, size_t... I>
+constexpr std::array<ZClipAudioProcessor::PathFn<T>, sizeof...(I)> ZClipAudioProcessor::makePathTable(std::index_sequence<I...>)
+{
+    return { &ZClipAudioProcessor::processPath<T, (I & 1) != 0, (I & 2) != 0, (int) ((I >> 2) & 3), (int) (I >> 4)>... };
+}
+
+template <typename T>
+const std::array<ZClipAudioProcessor::PathFn<T>, 48> ZClipAudioProcessor::pathTable = makePathTable<T>(std::make_index_sequence<48>());
+
+void ZClipAudioProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer&)  { processSamples(buffer); }
+void ZClipAudioProcessor::processBlock(AudioBuffer<double>& buffer, MidiBuffer&) { processSamples(buffer); }
+
+template <typename T>
+void ZClipAudioProcessor::processSamples(AudioBuffer<T>& buffer)
+{
+    ScopedNoDenormals _;
+    const int totalCh    = getTotalNumInputChannels();
+    const int numSamples = buffer.getNumSamples();
+    auto& eng = engineFor<T>();
+    if (chunkSize == 0) return;
+    jassert(eng.prepared);
+    if (! eng.prepared) return;
+    profiler.beginBlock();
+
+    int osChoiceNow, osEngineNow;
+    selectOversampling(osChoiceNow, osEngineNow, isNonRealtime());
+    int altChoiceNow, altEngineNow;
+    selectOversampling(altChoiceNow, altEngineNow, ! isNonRealtime());
+    const bool altChanged = altChoiceNow != altOSChoice || altEngineNow != altOSEngine;
+    altOSChoice = altChoiceNow;
+    altOSEngine = altEngineNow;
+    const int clipModeNow = jlimit(0, numClipModes - 1, (int) params.clipMode->load());
+    const int mbChoice    = jlimit(0, maxBands - 1, (int) params.mbBands->load());
+    const int bandsNow    = mbChoice > 0 ? mbChoice + 1 : 0;
+    int fadeFrom = -1, fadeEngine = currentOSEngine, fadeMode = currentClipMode;
+    bool freshAdaa = false;
+    if (osChoiceNow != currentOSChoice || osEngineNow != currentOSEngine || clipModeNow != currentClipMode
+        || bandsNow != currentBands)
+    {
+        // The outgoing path runs on a copy of its band splitter, so the new
+        // one starts the chunk from its own state even at the same factor.
+        // The oversampler is shared when only the clip mode or band layout
+        // changes; it is reset only when a different one takes over.
+        fadeFrom = currentOSChoice;
+        eng.mbFading = eng.multiband[(size_t) currentOSChoice];
+        const bool newOversampler = osChoiceNow != currentOSChoice || osEngineNow != currentOSEngine;
+        freshAdaa = newOversampler || clipModeNow != currentClipMode;
+        currentOSChoice = osChoiceNow;
+        currentOSEngine = osEngineNow;
+        currentClipMode = clipModeNow;
+        currentBands    = bandsNow;
+        if (auto* os = eng.oversamplerFor(currentOSEngine, currentOSChoice); os != nullptr && newOversampler) os->reset();
+        eng.multiband[(size_t) currentOSChoice].reset();
+        if (eng.osBypass.bypassed)
+        {
+            // The oversampler sat idle through the bypass; both sides of the
+            // crossfade need it fed with the input it missed.
+            auto prime = [&eng](Oversampler<T>* os)
             {
-                float* w = buffer.getWritePointer(ch);
-                for (int i = 0; i < numSamples; ++i) w[i] = jlimit(-ceilLin, ceilLin, w[i]);
-            }
+                if (os != nullptr)
+                    eng.osBypass.primeToEnd(*os, OversamplingBypass<T>::primeLengthFor(roundToInt(os->getLatencyInSamples())));
+            };
+            auto* outgoing = eng.oversamplerFor(fadeEngine, fadeFrom);
+            auto* incoming = eng.oversamplerFor(currentOSEngine, currentOSChoice);
+            prime(outgoing);
+            if (incoming != outgoing) prime(incoming);
+        }
+        eng.osBypass.bypassed = false;
+        eng.osBypass.linearRun = 0;
+        updateLatency();
     }
-    else
+    else if (altChanged) updateLatency();
+
+    const float pre      =          dbToLin(params.pregain->load());
+    const float ceilLin  = jlimit(0.01f, 1.0f, dbToLin(params.ceiling->load()));
+    const float out      =          dbToLin(params.output->load());
+    const float mix      =          params.mix->load() * 0.01f;
+    const bool  autoMk   =          params.automakeup->load() > 0.5f;
+
+    const bool  upOn     =          params.upEnable->load() > 0.5f;
+    const float upDb     =          params.upAmount->load();
+    const float upMax    =          dbToLin(upDb);
+    const float upKnee   = jlimit(0.0f, 12.0f, params.upKnee->load());
+    upLinked             =          params.upLink->load() > 0.5f;
+
+    const bool  ispProtect =       params.isp->load() > 0.5f;
+    const float driveDb  =          params.drive->load();
+    const float driveLin =          dbToLin(driveDb);
+
+    const float makeup = autoMk ? (1.0f / std::sqrt(jmax(ceilLin, 1.0e-6f))) : 1.0f;
+	const float softness = params.shape->load();
+
+    const float targets[ClipRamps::numRamps] = { pre * makeup, ceilLin, driveLin, mix };
+    for (int k = 0; k < ClipRamps::numRamps; ++k)
     {
-        for (int ch = 0; ch < totalCh; ++ch)
+        if (snapSmoothing) clipSmooth[(size_t) k].setCurrentAndTargetValue(targets[k]);
+        else               clipSmooth[(size_t) k].setTargetValue(targets[k]);
+    }
+    if (snapSmoothing) outSmooth.setCurrentAndTargetValue(out);
+    else               outSmooth.setTargetValue(out);
+    snapSmoothing = false;
+
+    if (upOn) upDetector.setCurve(ceilLin, upMax, upKnee);
+
+    float xovers[maxBands - 1], bandCeil[maxBands],
+          bandShape[maxBands], bandDrive[maxBands];
+    for (size_t k = 0; k < (size_t) maxBands - 1; ++k) xovers[k] = params.mbXover[k]->load();
+    for (size_t b = 0; b < (size_t) maxBands; ++b)
+    {
+        bandCeil[b]  = jlimit(0.01f, 1.0f, dbToLin(params.mbCeiling[b]->load()));
+        bandShape[b] = params.mbShape[b]->load();
+        bandDrive[b] = dbToLin(params.mbDrive[b]->load());
+    }
+    for (auto& mb : eng.multiband)
+    {
+        mb.setCrossovers(currentBands, xovers);
+        mb.setBands(bandCeil, bandShape, bandDrive);
+    }
+
+    bool silentIn = true;
+    for (int ch = 0; ch < totalCh && silentIn; ++ch)
+        silentIn = peakBelow(buffer.getReadPointer(ch), numSamples, (T) silenceFloor);
+    const bool settled = ! upOn || *std::max_element(upEnv.begin(), upEnv.begin() + (upLinked ? 1 : totalCh)) < envRestLevel;
+    if (silentIn && settled && silentRun >= tailSamples())
+    {
+        // Everything still in flight has rung out, so the filters, the
+        // limiter and the detector are cleared to the state silence leaves
+        // them in. When signal returns, processing resumes from there.
+        if (! asleep)
+        {
+            if (auto* os = eng.oversamplerFor(currentOSEngine, currentOSChoice)) os->reset();
+            eng.multiband[(size_t) currentOSChoice].reset();
+            eng.osBypass.reset();
+            eng.truePeak.reset();
+            eng.padBuffer.clear();
+            adaaState.fill({});
+            upEnv.fill(0.0f);
+            asleep = true;
+        }
+        silentRun += numSamples;
+        for (int k = 0; k < ClipRamps::numRamps; ++k) clipSmooth[(size_t) k].setCurrentAndTargetValue(targets[k]);
+        outSmooth.setCurrentAndTargetValue(out);
+
+        buffer.clear();
+        recentClipRatio.store(0.0f);
+        scopeFeed.push(buffer.getArrayOfReadPointers(), totalCh, numSamples);
+        if (meterResetPending.exchange(false)) meters.reset();
+        meters.processSilence(numSamples, totalCh * (numSamples << currentOSChoice));
+        profiler.endBlock(numSamples, sampleRate);
+        return;
+    }
+    asleep = false;
+    silentRun = silentIn ? silentRun + numSamples : 0;
+
+    const bool adaptive = params.osAdaptive->load() > 0.5f
+                       && adaptiveApplies(currentOSChoice, currentOSEngine, currentClipMode, currentBands);
+    const bool blend = mix < 1.0f || clipSmooth[ClipRamps::mix].isSmoothing();
+    const int  mode  = (upOn ? 1 : 0) | (blend ? 2 : 0);
+    const auto path  = pathTable<T>[(size_t) (mode | (currentOSChoice << 2) | (currentClipMode << 4))];
+    auto* const oversampler = eng.oversamplerFor(currentOSEngine, currentOSChoice);
+    const int  considered = totalCh * (numSamples << currentOSChoice);
+    int clippedCount = 0;
+
+    // Fixed-size chunks whatever the host block size; the smoothers, and
+    // with them the clip parameters and ramps, advance chunk by chunk.
+    auto block = dsp::AudioBlock<T>(buffer).getSubsetChannelBlock(0, (size_t) totalCh);
+    for (int start = 0; start < numSamples; start += (int) chunkSize)
+    {
+        const int len = jmin((int) chunkSize, numSamples - start);
+        auto sub = block.getSubBlock((size_t) start, (size_t) len);
+
+        const ClipParams clip(clipSmooth[ClipRamps::pre].getCurrentValue(), clipSmooth[ClipRamps::ceil].getCurrentValue(),
+                              softness, clipSmooth[ClipRamps::drive].getCurrentValue(), clipSmooth[ClipRamps::mix].getCurrentValue());
+        const ClipRamps* ramps = fillRamps(len) ? &clipRamps : nullptr;
+        if (upOn) detectUpward(sub, clip, ramps);
+
+        if (fadeFrom < 0 && (adaptive || eng.osBypass.bypassed))
         {
-            float* d = buffer.getWritePointer(ch);
-            for (int i = 0; i < numSamples; ++i)
+            clippedCount += processAdaptive(sub, path, oversampler, clip, ramps, adaptive, upOn);
+        }
+        else if (fadeFrom < 0)
+        {
+            clippedCount += (this->*path)(sub, oversampler, clip, ramps);
+        }
+        else
+        {
+            // Run the outgoing factor on a copy and fade it into the new one over this chunk.
+            auto old = dsp::AudioBlock<T>(eng.xfadeBuffer).getSubsetChannelBlock(0, (size_t) totalCh)
+                                                          .getSubBlock(0, (size_t) len);
+            old.copyFrom(sub);
+            const auto adaaSaved = adaaState;
+            eng.mbOutgoing = &eng.mbFading;
+            (this->*pathTable<T>[(size_t) (mode | (fadeFrom << 2) | (fadeMode << 4))])(old, eng.oversamplerFor(fadeEngine, fadeFrom), clip, ramps);
+            eng.mbOutgoing = nullptr;
+            // ADAA history from another mode or rate is meaningless to the new path.
+            if (freshAdaa) adaaState.fill({});
+            else           adaaState = adaaSaved;
+            clippedCount += (this->*path)(sub, oversampler, clip, ramps);
+
+            const float step = 1.0f / (float) len;
+            for (int ch = 0; ch < totalCh; ++ch)
             {
-                const float dry = d[i];
-                const float x   = dry * pre * makeup;
-                d[i] = processSample(x, dry, ch);
+                T* d = sub.getChannelPointer((size_t) ch);
+                const T* o = old.getChannelPointer((size_t) ch);
+                for (int i = 0; i < len; ++i) d[i] = o[i] + (T) ((float) (i + 1) * step) * (d[i] - o[i]);
             }
+            fadeFrom = -1;
         }
-    }
+        eng.pad(sub, latencyPad);
+
+        if (outSmooth.isSmoothing())
+        {
+            const float g0 = outSmooth.getCurrentValue();
+            buffer.applyGainRamp(start, len, (T) g0, (T) outSmooth.skip(len));
+        }
+        else buffer.applyGain(start, len, (T) outSmooth.getTargetValue());
 
-    buffer.applyGain(out);
+        // Runs with isp off too, so its delay line stays filled and the
+        // toggle only changes the gain.
+        {
+            const HotPathProfiler::Scope timed(profiler, ProfileRecord::truePeak);
+            eng.truePeak.process(buffer.getArrayOfWritePointers(), totalCh, start, len,
+                                 clipSmooth[ClipRamps::ceil].getCurrentValue(), ispProtect);
+        }
+    }
 
     for (int ch = totalCh; ch < getTotalNumOutputChannels(); ++ch)
         buffer.clear(ch, 0, numSamples);
 
     if (considered > 0) recentClipRatio.store((float) clippedCount / (float) considered);
 
-    const float* ch0 = buffer.getReadPointer(0);
-    const float* ch1 = (buffer.getNumChannels() > 1) ? buffer.getReadPointer(1) : ch0;
-    const float* chData[2] = { ch0, ch1 };
-    pushToScope(chData, jmin(2, buffer.getNumChannels()), numSamples, 1);
+    {
+        const HotPathProfiler::Scope timed(profiler, ProfileRecord::scope);
+        scopeFeed.push(buffer.getArrayOfReadPointers(), totalCh, numSamples);
+    }
+    {
+        const HotPathProfiler::Scope timed(profiler, ProfileRecord::meters);
+        if (meterResetPending.exchange(false)) meters.reset();
+        meters.process(buffer.getArrayOfReadPointers(), totalCh, numSamples, clippedCount, considered,
+                       eng.truePeak.takeMinGain());
+    }
+    profiler.endBlock(numSamples, sampleRate);
+}
+
+bool ZClipAudioProcessor::fillRamps(int numSamples)
+{
+    bool smoothing = false;
+    for (auto& sm : clipSmooth) smoothing = smoothing || sm.isSmoothing();
+    if (!smoothing) return false;
+
+    for (int k = 0; k < ClipRamps::numRamps; ++k)
+    {
+        auto& sm = clipSmooth[(size_t) k];
+        float* dst = rampBuffer.getWritePointer(k);
+        clipRamps.start[k] = sm.getCurrentValue();
+        for (int i = 0; i < numSamples; ++i) dst[i] = sm.getNextValue();
+        clipRamps.data[k] = dst;
+    }
+    return true;
+}
+
+void ZClipAudioProcessor::updateDetector()
+{
+    upDetector.prepare(sampleRate, envAttack, envRelease);
 }
 
-void ZClipAudioProcessor::pushToScope(const float* const* data, int numChannels, int numSamples, int stride)
+template <typename T>
+void ZClipAudioProcessor::Engine<T>::prepare(double sampleRate, int numChannels, size_t maxBlock)
 {
-    const int toPush = numSamples / stride;
-    int start1=0,size1=0,start2=0,size2=0;
-    const int chans = jmin(2, numChannels);
-    scopeFifo.prepareToWrite(toPush, start1, size1, start2, size2);
-    if (size1 + size2 > 0)
+    // Linear phase: equiripple half-band FIR stages. The IIR engines are
+    // polyphase allpass half-bands, the low-latency one with fewer sections.
+    // Integer latency adds a fractional delay where needed, so the latency
+    // reported to the host is exact rather than rounded.
+    for (int engine = 0; engine < numOsEngines; ++engine)
     {
-        for (int c = 0; c < chans; ++c)
+        auto& set = oversamplers[(size_t) engine];
+        set[0].reset();
+        for (size_t factorPow = 1; factorPow < set.size(); ++factorPow)
         {
-            if (size1 > 0) for (int i = 0; i < size1; ++i) scopeBuffer.setSample(c, start1 + i, data[c][i * stride]);
-            if (size2 > 0) for (int i = 0; i < size2; ++i) scopeBuffer.setSample(c, start2 + i, data[c][(size1 + i) * stride]);
+            auto& os = set[factorPow];
+            os.reset(new Oversampler<T>((size_t) jmax(1, numChannels), factorPow,
+                                        engine == osLinearPhase ? Oversampler<T>::filterHalfBandFIREquiripple
+                                                                : Oversampler<T>::filterHalfBandPolyphaseIIR,
+                                        engine != osIirLowLatency, true));
+            os->initProcessing(maxBlock);
+            os->reset();
         }
-        scopeFifo.finishedWrite(size1 + size2);
     }
+
+    const int nch = jmax(1, numChannels);
+    xfadeBuffer.setSize(nch, (int) maxBlock, false, true, false);
+    mbDryBuffer.setSize(nch, (int) maxBlock * 8, false, true, false);
+    osBypass.prepare(numChannels, (int) maxBlock);
+    truePeak.prepare(sampleRate, numChannels);
+    for (size_t k = 0; k < multiband.size(); ++k) multiband[k].prepare(sampleRate * (double) (1 << k));
+    mbOutgoing = nullptr;
+
+    // The pad never exceeds the longest oversampler latency plus the ADAA
+    // delay and rounding.
+    double maxLatency = 0.0;
+    for (auto& set : oversamplers)
+        for (auto& os : set)
+            if (os != nullptr) maxLatency = jmax(maxLatency, (double) os->getLatencyInSamples());
+    padBuffer.setSize(nch, (int) std::ceil(maxLatency) + 3, false, true, false);
+    padPos = 0;
+    prepared = true;
 }
 
-void ZClipAudioProcessor::readScope(AudioBuffer<float>& dest)
+template <typename T>
+void ZClipAudioProcessor::Engine<T>::pad(const dsp::AudioBlock<T>& block, int delay) noexcept
 {
-    const int want = dest.getNumSamples();
-    int start1=0,size1=0,start2=0,size2=0;
-    scopeFifo.prepareToRead(want, start1, size1, start2, size2);
-    if (size1 + size2 > 0)
+    // Runs with no delay too, so the line holds real history whenever the
+    // pad changes.
+    const int cap = padBuffer.getNumSamples(), n = (int) block.getNumSamples();
+    jassert(delay >= 0 && delay < cap);
+    for (int ch = 0; ch < (int) block.getNumChannels(); ++ch)
     {
-        const int chans = jmin(2, dest.getNumChannels());
-        for (int c = 0; c < chans; ++c)
+        T* ring = padBuffer.getWritePointer(ch);
+        T* d = block.getChannelPointer((size_t) ch);
+        for (int i = 0, w = padPos; i < n; ++i, w = (w + 1 == cap ? 0 : w + 1))
         {
-            if (size1 > 0) dest.copyFrom(c, 0,     scopeBuffer, c, start1, size1);
-            if (size2 > 0) dest.copyFrom(c, size1, scopeBuffer, c, start2, size2);
+            ring[w] = d[i];
+            d[i] = ring[w >= delay ? w - delay : w - delay + cap];
         }
-        scopeFifo.finishedRead(size1 + size2);
-        if (size1 + size2 < want) dest.clear(0, size1 + size2, want - (size1 + size2));
-    } else dest.clear();
+    }
+    padPos = (padPos + n) % cap;
+}
+
+template <typename T>
+void ZClipAudioProcessor::Engine<T>::release()
+{
+    for (auto& set : oversamplers) for (auto& os : set) os.reset();
+    xfadeBuffer.setSize(0, 0);
+    mbDryBuffer.setSize(0, 0);
+    padBuffer.setSize(0, 0);
+    prepared = false;
 }
 
-void ZClipAudioProcessor::ensureOversampler(int osChoice, int numChannels, size_t maxBlock)
+// Reports the longer of the realtime and offline latencies, so a host that
+// switches to an offline render with render_os set keeps its compensation;
+// the shorter path is padded to match.
+void ZClipAudioProcessor::updateLatency()
 {
-    const int factorPow = osChoice;
-    if (factorPow <= 0) { oversampler.reset(); return; }
-    oversampler.reset(new dsp::Oversampling<float>(
-        numChannels, factorPow,
-        dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true));
-    oversampler->initProcessing(maxBlock);
+    // ADAA delays the curve by half a sample per order at the clipping rate.
+    // The latencies don't depend on the sample type, so whichever engine is
+    // prepared answers for both.
+    auto latencyOf = [this](auto& eng, int engine, int choice)
+    {
+        auto* os = eng.oversamplerFor(engine, choice);
+        const double adaaDelay = 0.5 * (double) currentClipMode / (double) (1 << choice);
+        return (int) std::lround((os != nullptr ? os->getLatencyInSamples() : 0.0)
+                                 + (double) eng.truePeak.getLatencySamples() + adaaDelay);
+    };
+    auto latencyFor = [&](int engine, int choice)
+    {
+        return doubleEngine.prepared ? latencyOf(doubleEngine, engine, choice) : latencyOf(floatEngine, engine, choice);
+    };
+    const int current = latencyFor(currentOSEngine, currentOSChoice);
+    const int reported = jmax(current, latencyFor(altOSEngine, altOSChoice));
+    latencyPad = reported - current;
+    setLatencySamples(reported);
+}
+
+// Output that can follow the last non-silent input: the latency plus the
+// ring-out of the oversampling filters (well inside 10 ms) and, in
+// multiband mode, of the lowest crossover. Its Butterworth sections decay
+// with a time constant of 1 / (2 pi f 0.707), so -120 dB takes about 3.1 / f;
+// 4 / f covers the cascade.
+int ZClipAudioProcessor::tailSamples() const noexcept
+{
+    double ringOut = 0.01;
+    if (currentBands > 1)
+        ringOut = jmax(ringOut, 4.0 / (double) jmax(20.0f, params.mbXover[0]->load()));
+    return getLatencySamples() + (int) std::ceil(ringOut * sampleRate);
+}
+
+// The factor and filter engine for realtime or offline processing: the os
+// and os_filter parameters, or, offline with render_os set, at least that
+// factor and the full IIR in place of the low-latency one. Every factor and
+// engine is prepared in prepareToPlay, so the switch allocates nothing; it
+// goes through the usual crossfade, and the reported latency already covers
+// both.
+void ZClipAudioProcessor::selectOversampling(int& choice, int& engine, bool offline) const
+{
+    choice = jlimit(0, 3, (int) params.os->load());
+    engine = jlimit(0, numOsEngines - 1, (int) params.osFilter->load());
+
+    const int renderChoice = jlimit(0, 3, (int) params.renderOs->load());
+    if (offline && renderChoice > 0)
+    {
+        choice = jmax(choice, renderChoice);
+        if (engine == osIirLowLatency) engine = osIirMaxQuality;
+    }
+}
+
+bool ZClipAudioProcessor::isAdaptiveOsAvailable() const
+{
+    int choice, engine;
+    selectOversampling(choice, engine, isNonRealtime());
+    const int mbChoice = jlimit(0, maxBands - 1, (int) params.mbBands->load());
+    return adaptiveApplies(choice, engine, jlimit(0, numClipModes - 1, (int) params.clipMode->load()), mbChoice > 0 ? mbChoice + 1 : 0);
+}
+
+double ZClipAudioProcessor::getTailLengthSeconds() const
+{
+    return sampleRate > 0.0 ? (double) tailSamples() / sampleRate : 0.0;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout ZClipAudioProcessor::createLayout()
@@ -240,14 +796,32 @@ juce::AudioProcessorValueTreeState::ParameterLayout ZClipAudioProcessor::createL
     p.push_back(std::make_unique<AudioParameterBool>("up_enable","Upward Compression",false));
 	p.push_back(std::make_unique<AudioParameterFloat>("up_amount","Upward Gain (dB)",NormalisableRange<float>(0.0f,6.0f,0.01f),0.0f));
 	p.push_back(std::make_unique<AudioParameterFloat>("up_knee","Upward Knee (dB)",NormalisableRange<float>(0.0f,12.0f,0.01f),6.0f));
+	p.push_back(std::make_unique<AudioParameterBool>("up_link","Link Channels",false));
 
 
     p.push_back(std::make_unique<AudioParameterFloat>("mix","Mix",NormalisableRange<float>(0.0f,100.0f,0.01f),100.0f));
     p.push_back(std::make_unique<AudioParameterFloat>("output","Output",NormalisableRange<float>(-24.0f,24.0f,0.01f),0.0f));
 
     p.push_back(std::make_unique<AudioParameterChoice>("os","Oversampling",StringArray{"1x","2x","4x","8x"},2));
+    p.push_back(std::make_unique<AudioParameterChoice>("os_filter","OS Filter",StringArray{"Linear Phase","IIR","IIR Low Latency"},1));
+    p.push_back(std::make_unique<AudioParameterBool>("os_adaptive","Adaptive Oversampling",false));
+    p.push_back(std::make_unique<AudioParameterChoice>("render_os","Render Oversampling",StringArray{"Off","2x","4x","8x"},0));
+    p.push_back(std::make_unique<AudioParameterChoice>("clip_mode","Clip Mode",StringArray{"Direct","ADAA 1st Order","ADAA 2nd Order"},0));
     p.push_back(std::make_unique<AudioParameterBool>("isp","TruePeakProtect",true));
 
+    p.push_back(std::make_unique<AudioParameterChoice>("mb_bands","Multiband",StringArray{"Off","2 Bands","3 Bands","4 Bands"},0));
+    const float xoverDefaults[] = { 120.0f, 1000.0f, 6000.0f };
+    for (int k = 0; k < maxBands - 1; ++k)
+        p.push_back(std::make_unique<AudioParameterFloat>("mb_xover" + String(k + 1), "Crossover " + String(k + 1),
+                                                          NormalisableRange<float>(20.0f,20000.0f,1.0f,0.25f), xoverDefaults[k]));
+    for (int b = 0; b < maxBands; ++b)
+    {
+        const String n(b + 1);
+        p.push_back(std::make_unique<AudioParameterFloat>("mb_ceiling" + n,"Band " + n + " Ceiling",NormalisableRange<float>(-18.0f,0.0f,0.01f),0.0f));
+        p.push_back(std::make_unique<AudioParameterFloat>("mb_shape" + n,"Band " + n + " Shape",NormalisableRange<float>(0.0f,1.0f,0.001f),0.5f));
+        p.push_back(std::make_unique<AudioParameterFloat>("mb_drive" + n,"Band " + n + " Drive",NormalisableRange<float>(0.0f,12.0f,0.01f),0.0f));
+    }
+
     p.push_back(std::make_unique<AudioParameterFloat>("drive","Drive",NormalisableRange<float>(0.0f,12.0f,0.01f),0.0f));
 	
 	p.push_back(std::make_unique<AudioParameterFloat>("shape","Shape", NormalisableRange<float>(0.0f,1.0f,0.001f), 0.0f));
@@ -273,6 +847,5 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() { return new ZClipAudio
 
 float ZClipAudioProcessor::getCeilingDb()
 {
-    if (auto* p = apvts.getRawParameterValue("ceiling")) return p->load();
-    return 0.0f;
+    return params.ceiling != nullptr ? params.ceiling->load() : 0.0f;
 }
@@ -1,6 +1,17 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "UpwardDetector.h"
+#include "ClipKernel.h"
+#include "TruePeakLimiter.h"
+#include "ScopeFeed.h"
+#include "Metering.h"
+#include "OversamplingBypass.h"
+#include "MultibandClipper.h"
+#include "Profiler.h"
+#include <array>
+#include <type_traits>
+#include <utility>
 class ZClipAudioProcessor : public juce::AudioProcessor{
 public:
 
@@ -11,27 +22,155 @@ public:
     void prepareToPlay(double, int) override; void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout&) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
     juce::AudioProcessorEditor* createEditor() override; bool hasEditor() const override { return true; }
     const juce::String getName() const override { return "Z-Clip"; }
     bool acceptsMidi() const override { return false; } bool producesMidi() const override { return false; }
-    bool isMidiEffect() const override { return false; } double getTailLengthSeconds() const override { return 0.0; }
+    bool isMidiEffect() const override { return false; } double getTailLengthSeconds() const override;
     int getNumPrograms() override { return 1; } int getCurrentProgram() override { return 0; }
     void setCurrentProgram(int) override {} const juce::String getProgramName(int) override { return {}; }
     void changeProgramName(int, const juce::String&) override {}
     void getStateInformation(juce::MemoryBlock&) override; void setStateInformation(const void*, int) override;
     juce::AudioProcessorValueTreeState apvts;
-    void readScope(juce::AudioBuffer<float>& dest);
+    int readScope(ScopeFrame* dest, int maxFrames) { return scopeFeed.read(dest, maxFrames); }
     float getRecentClipRatio() const noexcept { return recentClipRatio.load(); }
+    void readMeters(MeterSnapshot& dest) const noexcept { meters.read(dest); }
+    // Publishes the meters' partial last step. Same thread as processBlock.
+    void flushMeters() noexcept { meters.flush(); }
+    void resetMeters() noexcept { meterResetPending.store(true); }
+    // Per-block stage timings; always empty unless built with ZCLIP_PROFILE.
+    int readProfile(ProfileRecord* dest, int maxRecords) { return profiler.read(dest, maxRecords); }
+    uint64_t getProfileDropped() const noexcept { return profiler.getDropped(); }
+    // Whether the current settings let os_adaptive take effect.
+    bool isAdaptiveOsAvailable() const;
 private:
+    template <typename T> using Oversampler = juce::dsp::Oversampling<T>;
+    template <typename T>
+    using PathFn = int (ZClipAudioProcessor::*)(juce::dsp::AudioBlock<T>, Oversampler<T>*, const ClipParams&, const ClipRamps*);
+    template <typename T, bool Up, bool Blend, int OsPow, int Mode>
+    int processPath(juce::dsp::AudioBlock<T>, Oversampler<T>*, const ClipParams&, const ClipRamps*);
+    template <typename T, size_t... I>
+    static constexpr std::array<PathFn<T>, sizeof...(I)> makePathTable(std::index_sequence<I...>);
+    template <typename T>
+    static const std::array<PathFn<T>, 48> pathTable;
+    template <bool HasGain, bool Blend, int Mode, typename T>
+    int clipChannel(T* d, int n, const ClipParams&, const float* const* r, const float* gain, int ch) noexcept;
+    template <typename T>
+    int processAdaptive(juce::dsp::AudioBlock<T>, PathFn<T>, Oversampler<T>*, const ClipParams&, const ClipRamps*, bool allowBypass, bool up);
+    template <typename T>
+    void detectUpward(const juce::dsp::AudioBlock<T>&, const ClipParams&, const ClipRamps*) noexcept;
+    template <typename T>
+    void processSamples(juce::AudioBuffer<T>&);
+
     juce::AudioProcessorValueTreeState::ParameterLayout createLayout();
-    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
-    int currentOSChoice = 0; size_t currentMaxBlock = 0; double sampleRate = 44100.0;
-    float levelEnvL = 0.0f, levelEnvR = 0.0f; float envAttack = 0.001f, envRelease = 0.050f;
-    juce::AudioBuffer<float> scopeBuffer {2, 8192};
-    juce::AbstractFifo scopeFifo {8192};
+    struct ParamHandles
+    {
+        std::atomic<float>* pregain = nullptr; std::atomic<float>* ceiling = nullptr; std::atomic<float>* automakeup = nullptr;
+        std::atomic<float>* upEnable = nullptr; std::atomic<float>* upAmount = nullptr; std::atomic<float>* upKnee = nullptr;
+        std::atomic<float>* mix = nullptr; std::atomic<float>* output = nullptr; std::atomic<float>* os = nullptr;
+        std::atomic<float>* isp = nullptr; std::atomic<float>* drive = nullptr; std::atomic<float>* shape = nullptr;
+        std::atomic<float>* upLink = nullptr; std::atomic<float>* osFilter = nullptr;
+        std::atomic<float>* osAdaptive = nullptr; std::atomic<float>* clipMode = nullptr; std::atomic<float>* renderOs = nullptr;
+        std::atomic<float>* mbBands = nullptr; std::array<std::atomic<float>*, maxBands - 1> mbXover {};
+        std::array<std::atomic<float>*, maxBands> mbCeiling {}, mbShape {}, mbDrive {};
+    } params;
+
+    static constexpr double smoothingSeconds = 0.02;
+    // Host blocks are processed in chunks of at most this many base-rate
+    // samples, so working buffers stay cache-sized (2048 samples per channel
+    // at 8x) and their size doesn't depend on the host's block size.
+    static constexpr int subBlockSize = 256;
+    std::array<juce::SmoothedValue<float>, ClipRamps::numRamps> clipSmooth;
+    juce::SmoothedValue<float> outSmooth;
+    bool snapSmoothing = true;
+    juce::AudioBuffer<float> rampBuffer, osRampBuffer;
+    ClipRamps clipRamps {};
+    // Oversampling filter engines, indexed by the os_filter choice.
+    enum { osLinearPhase, osIirMaxQuality, osIirLowLatency, numOsEngines };
+
+    // Audio-rate state in the host's sample type. Only the engine for the
+    // current processing precision is prepared; the other stays empty.
+    // The multiband splitters are one per oversampling factor since the
+    // crossovers run at the clipping rate. mbOutgoing, when set, stands in
+    // for the current factor's splitter while the old band layout fades out.
+    template <typename T>
+    struct Engine
+    {
+        std::array<std::array<std::unique_ptr<Oversampler<T>>, 4>, numOsEngines> oversamplers;
+        Oversampler<T>* oversamplerFor(int engine, int factorPow) const noexcept { return oversamplers[(size_t) engine][(size_t) factorPow].get(); }
+        juce::AudioBuffer<T> xfadeBuffer, mbDryBuffer;
+        OversamplingBypass<T> osBypass;
+        TruePeakLimiter<T> truePeak;
+        std::array<MultibandClipper<T>, 4> multiband;
+        MultibandClipper<T> mbFading;
+        MultibandClipper<T>* mbOutgoing = nullptr;
+        // Delay line that pads the path's latency up to the reported one.
+        juce::AudioBuffer<T> padBuffer;
+        int padPos = 0;
+        bool prepared = false;
+
+        void prepare(double sampleRate, int numChannels, size_t maxBlock);
+        void release();
+        void pad(const juce::dsp::AudioBlock<T>& block, int delay) noexcept;
+    };
+    Engine<float> floatEngine;
+    Engine<double> doubleEngine;
+    template <typename T>
+    Engine<T>& engineFor() noexcept
+    {
+        if constexpr (std::is_same_v<T, double>) return doubleEngine;
+        else                                      return floatEngine;
+    }
+
+    // Adaptive oversampling: chunks whose peak stays below bypassHeadroom of
+    // the knee (and of the ceiling, for the dry share) skip the oversampler.
+    static constexpr float bypassHeadroom = 0.7f;
+    // The bypass needs oversampling with the same delay at every frequency
+    // (linear phase), the direct clip curve and no band split.
+    static constexpr bool adaptiveApplies(int choice, int engine, int clipMode, int bands) noexcept
+    {
+        return choice > 0 && engine == osLinearPhase && clipMode == clipDirect && bands == 0;
+    }
+    juce::AudioBuffer<float> bypassGainBuffer;
+    // Clip curve evaluation, indexed by the clip_mode choice; the ADAA
+    // modes double as the antiderivative order.
+    enum { clipDirect, clipAdaa1, clipAdaa2, numClipModes };
+    std::array<AdaaState, UpwardDetector::maxChannels> adaaState {};
+    juce::HeapBlock<float> unityRamp;
+    int currentBands = 0;
+
+    int currentOSChoice = 0, currentOSEngine = osIirMaxQuality, currentClipMode = clipDirect; size_t chunkSize = 0; double sampleRate = 44100.0;
+    // The oversampling the other of realtime and offline processing would
+    // select. The reported latency covers both, and latencyPad delays the
+    // output of whichever is shorter to match.
+    int altOSChoice = 0, altOSEngine = osIirMaxQuality, latencyPad = 0;
+    float envAttack = 0.001f, envRelease = 0.050f;
+    UpwardDetector upDetector;
+    alignas(32) std::array<float, UpwardDetector::maxChannels> upEnv {};
+    bool upLinked = false;
+    // Upward gain is detected at the base rate, one chunk ahead of the
+    // path; upGainStart holds each channel's gain just before the chunk,
+    // from which the oversampled paths interpolate into upGainOsBuffer.
+    juce::AudioBuffer<float> upGainBuffer, upGainOsBuffer;
+    std::array<float, UpwardDetector::maxChannels> upGainStart {}, upGainPrev {};
+    ScopeFeed scopeFeed;
     std::atomic<float> recentClipRatio {0.0f};
-    void pushToScope(const float* const* data, int numChannels, int numSamples, int stride = 8);
-    void ensureOversampler(int osChoice, int numChannels, size_t maxBlock);
+    MeterEngine meters;
+    std::atomic<bool> meterResetPending {false};
+    HotPathProfiler profiler;
+    // Silence fast path: once the input has stayed below silenceFloor for
+    // longer than the tail and the upward detector has settled, blocks are
+    // zeroed without running the DSP.
+    static constexpr float silenceFloor = 1.0e-8f; // -160 dBFS
+    static constexpr float envRestLevel = 1.0e-5f;
+    juce::int64 silentRun = 0;
+    bool asleep = false;
+    int tailSamples() const noexcept;
+    void updateLatency();
+    void selectOversampling(int& choice, int& engine, bool offline) const;
+    bool fillRamps(int numSamples);
+    void updateDetector();
     static inline float dbToLin(float dB){ return std::pow(10.0f, dB*0.05f); }
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ZClipAudioProcessor)
 };
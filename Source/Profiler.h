@@ -0,0 +1,263 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Hot-path instrumentation, compiled in with ZCLIP_PROFILE=1 (the CMake
+// option of the same name). Without it HotPathProfiler is an empty stub and
+// every call on it compiles away.
+#ifndef ZCLIP_PROFILE
+ #define ZCLIP_PROFILE 0
+#endif
+
+#if ZCLIP_PROFILE
+ #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+  #define ZCLIP_PROFILE_TSC 1
+ #elif defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define ZCLIP_PROFILE_TSC 1
+ #else
+  #define ZCLIP_PROFILE_TSC 0
+ #endif
+#endif
+
+// Timings of one processBlock call, in ticks of the cycle counter (TSC
+// cycles, or nanoseconds where there is none). Stages are summed over the
+// chunks of the block and, during a crossfade, over both paths; `total`
+// covers the whole call, so what it has beyond the stages is parameter
+// handling, ramps, crossfades and the adaptive bypass.
+struct ProfileRecord
+{
+    enum Stage { upsample, detect, shape, downsample, truePeak, scope, meters, numStages };
+
+    static const char* stageName(int s) noexcept
+    {
+        static const char* const names[numStages] = { "upsample", "detect", "shape", "downsample", "true peak", "scope", "meters" };
+        return s >= 0 && s < numStages ? names[s] : "block";
+    }
+
+    static const char* tickUnit() noexcept
+    {
+       #if ZCLIP_PROFILE && ZCLIP_PROFILE_TSC
+        return "cycles";
+       #else
+        return "ns";
+       #endif
+    }
+
+    uint64_t ticks[numStages];
+    uint64_t total;
+    uint64_t wallNs;
+    int numSamples;
+    double sampleRate;
+};
+
+#if ZCLIP_PROFILE
+// Audio-thread side. Stage scopes accumulate into the current block's
+// record, which endBlock() hands to the GUI through a single-producer/
+// single-consumer ring. Nothing here allocates or locks.
+class HotPathProfiler
+{
+public:
+    static constexpr bool enabled = true;
+    static constexpr int capacity = 1024;
+
+    static uint64_t now() noexcept
+    {
+       #if ZCLIP_PROFILE_TSC
+        return (uint64_t) __rdtsc();
+       #else
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch()).count();
+       #endif
+    }
+
+    // Adds the time from construction to destruction to one stage.
+    class Scope
+    {
+    public:
+        Scope(HotPathProfiler& p, ProfileRecord::Stage s) noexcept : owner(p), stage(s), start(now()) {}
+        ~Scope() { owner.current.ticks[stage] += now() - start; }
+
+    private:
+        HotPathProfiler& owner;
+        const ProfileRecord::Stage stage;
+        const uint64_t start;
+    };
+
+    void beginBlock() noexcept
+    {
+        current = {};
+        wallStart = std::chrono::steady_clock::now();
+        blockStart = now();
+    }
+
+    // Audio thread. Records that don't fit are counted and dropped.
+    void endBlock(int numSamples, double sampleRate) noexcept
+    {
+        current.total = now() - blockStart;
+        current.wallNs = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - wallStart).count();
+        current.numSamples = numSamples;
+        current.sampleRate = sampleRate;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 > 0)
+        {
+            ring[(size_t) start1] = current;
+            fifo.finishedWrite(1);
+        }
+        else dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // GUI thread. Returns the number of records copied, oldest first.
+    int read(ProfileRecord* dest, int maxRecords) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxRecords, start1, size1, start2, size2);
+        for (int i = 0; i < size1; ++i) dest[i]         = ring[(size_t) (start1 + i)];
+        for (int i = 0; i < size2; ++i) dest[size1 + i] = ring[(size_t) (start2 + i)];
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    uint64_t getDropped() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<ProfileRecord, capacity> ring {};
+    ProfileRecord current {};
+    uint64_t blockStart = 0;
+    std::chrono::steady_clock::time_point wallStart {};
+    std::atomic<uint64_t> dropped { 0 };
+};
+#else
+class HotPathProfiler
+{
+public:
+    static constexpr bool enabled = false;
+
+    struct Scope
+    {
+        Scope(HotPathProfiler&, ProfileRecord::Stage) noexcept {}
+    };
+
+    void beginBlock() noexcept {}
+    void endBlock(int, double) noexcept {}
+    int read(ProfileRecord*, int) noexcept { return 0; }
+    uint64_t getDropped() const noexcept { return 0; }
+};
+#endif
+
+// Statistics over the most recent records: per-stage percentiles and worst
+// case per block, and the block's wall-clock load against its deadline
+// (the audio duration of the block). Deadline misses and the worst load are
+// kept since the last reset, not just over the window. GUI or tool thread
+// only; this allocates.
+class ProfileStats
+{
+public:
+    static constexpr int window = 4096;
+
+    void add(const ProfileRecord& r)
+    {
+        if ((int) records.size() < window) records.push_back(r);
+        else records[(size_t) next] = r;
+        next = (next + 1) % window;
+
+        ++blocks;
+        const double l = load(r);
+        worstLoad = std::max(worstLoad, l);
+        if (l > 1.0) ++misses;
+    }
+
+    void reset()
+    {
+        records.clear();
+        next = 0;
+        blocks = misses = 0;
+        worstLoad = 0.0;
+    }
+
+    int getNumRecords() const noexcept { return (int) records.size(); }
+
+    // Multi-line, fixed-width summary for the overlay and dump files.
+    juce::String describe(uint64_t dropped) const
+    {
+        juce::String s;
+        s << "blocks " << (juce::int64) blocks << " (window " << (int) records.size() << ", dropped " << (juce::int64) dropped
+          << ")  misses " << (juce::int64) misses << "  worst load " << juce::String(100.0 * worstLoad, 1) << "%\n";
+        if (records.empty()) return s;
+
+        s << pad("", 11) << pad("p50", 9) << pad("p95", 9) << pad("p99", 9) << pad("max", 9)
+          << "  " << ProfileRecord::tickUnit() << "/block; p50 per sample\n";
+        std::vector<double> v(records.size()), perSample(records.size());
+        for (int st = 0; st <= ProfileRecord::numStages; ++st)
+        {
+            for (size_t i = 0; i < records.size(); ++i)
+            {
+                const auto& r = records[i];
+                v[i] = (double) (st < ProfileRecord::numStages ? r.ticks[st] : r.total);
+                perSample[i] = v[i] / (double) std::max(1, r.numSamples);
+            }
+            s << juce::String(ProfileRecord::stageName(st)).paddedRight(' ', 11) << pad(ticks(percentile(v, 0.50)), 9) << pad(ticks(percentile(v, 0.95)), 9)
+              << pad(ticks(percentile(v, 0.99)), 9) << pad(ticks(percentile(v, 1.0)), 9)
+              << "  " << juce::String(percentile(perSample, 0.50), 1) << "\n";
+        }
+
+        for (size_t i = 0; i < records.size(); ++i) v[i] = 100.0 * load(records[i]);
+        s << juce::String("load %").paddedRight(' ', 11) << pad(juce::String(percentile(v, 0.50), 1), 9) << pad(juce::String(percentile(v, 0.95), 1), 9)
+          << pad(juce::String(percentile(v, 0.99), 1), 9) << pad(juce::String(percentile(v, 1.0), 1), 9) << "\n";
+        return s;
+    }
+
+    // Writes the summary followed by the window as CSV, oldest block first.
+    bool dump(const juce::File& file, uint64_t dropped) const
+    {
+        juce::String s = describe(dropped);
+        s << "\nsamples,sample_rate,wall_ns";
+        for (int st = 0; st < ProfileRecord::numStages; ++st) s << "," << juce::String(ProfileRecord::stageName(st)).replaceCharacter(' ', '_');
+        s << ",total\n";
+
+        const size_t n = records.size(), first = n < (size_t) window ? 0 : (size_t) next;
+        for (size_t k = 0; k < n; ++k)
+        {
+            const auto& r = records[(first + k) % n];
+            s << r.numSamples << "," << r.sampleRate << "," << (juce::int64) r.wallNs;
+            for (auto t : r.ticks) s << "," << (juce::int64) t;
+            s << "," << (juce::int64) r.total << "\n";
+        }
+        return file.getParentDirectory().createDirectory() && file.replaceWithText(s);
+    }
+
+private:
+    static double load(const ProfileRecord& r) noexcept
+    {
+        const double deadlineNs = 1.0e9 * (double) r.numSamples / std::max(1.0, r.sampleRate);
+        return deadlineNs > 0.0 ? (double) r.wallNs / deadlineNs : 0.0;
+    }
+
+    // Nearest-rank percentile; reorders v.
+    static double percentile(std::vector<double>& v, double q)
+    {
+        if (v.empty()) return 0.0;
+        const auto k = (size_t) juce::jlimit(0.0, (double) v.size() - 1.0, std::ceil(q * (double) v.size()) - 1.0);
+        std::nth_element(v.begin(), v.begin() + (std::ptrdiff_t) k, v.end());
+        return v[k];
+    }
+
+    static juce::String ticks(double t) { return t >= 1.0e6 ? juce::String(t * 1.0e-6, 2) + "M" : juce::String((juce::int64) t); }
+    static juce::String pad(const juce::String& t, int w) { return t.paddedLeft(' ', w); }
+
+    std::vector<ProfileRecord> records;
+    int next = 0;
+    uint64_t blocks = 0, misses = 0;
+    double worstLoad = 0.0;
+};
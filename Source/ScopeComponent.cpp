@@ -1,72 +1,107 @@
 #include "ScopeComponent.h"
 using namespace juce;
 
-ScopeComponent::ScopeComponent(std::function<void(AudioBuffer<float>&)> reader,
+static constexpr float radius = 12.0f;
+static constexpr float plotScale = 0.40f;
+
+ScopeComponent::ScopeComponent(std::function<int(ScopeFrame*, int)> reader,
                                std::function<float()> ceilingGetter)
     : readFn(std::move(reader)), getCeiling(std::move(ceilingGetter))
 {
-    buf.setSize(2, 2048, false, true, true);
-    setOpaque(false);
+    incoming.resize(ScopeFeed::capacity);
+    setOpaque(true);
     startTimerHz(30);
 }
 
-void ScopeComponent::timerCallback() { repaint(); }
-
-void ScopeComponent::paint(juce::Graphics& g)
+void ScopeComponent::resized()
 {
-    if (readFn) readFn(buf);
+    plot = getLocalBounds().reduced(6);
+    plotClip.clear();
+    plotClip.addRoundedRectangle(plot.toFloat(), radius);
 
-    g.fillAll(Colour::fromFloatRGBA(0.07f, 0.08f, 0.10f, 1.0f));
+    if (plot.isEmpty()) { wave = {}; staticFrame = {}; return; }
+    wave = Image(Image::ARGB, plot.getWidth(), plot.getHeight(), true);
+    renderStaticFrame();
+}
 
-    auto bounds = getLocalBounds().reduced(6);
-    auto radius = 12.0f;
-    auto w = bounds.getWidth();
-    auto h = bounds.getHeight();
-    auto midY = (float) bounds.getCentreY();
+void ScopeComponent::renderStaticFrame()
+{
+    if (getWidth() <= 0 || getHeight() <= 0) return;
+    staticFrame = Image(Image::RGB, getWidth(), getHeight(), false);
+    Graphics g(staticFrame);
 
-    Path clip; clip.addRoundedRectangle(bounds.toFloat(), radius);
-    g.reduceClipRegion(clip);
+    g.fillAll(Colour::fromFloatRGBA(0.07f, 0.08f, 0.10f, 1.0f));
+    g.reduceClipRegion(plotClip);
 
     g.setColour(Colour::fromFloatRGBA(0.10f, 0.12f, 0.14f, 1.0f));
-    g.fillRoundedRectangle(bounds.toFloat(), radius);
+    g.fillRoundedRectangle(plot.toFloat(), radius);
 
     g.setColour(Colours::black);
-    g.drawRoundedRectangle(bounds.toFloat(), radius, 2.0f);
+    g.drawRoundedRectangle(plot.toFloat(), radius, 2.0f);
+
+    shownCeilingDb = jlimit(-24.0f, 0.0f, getCeiling ? getCeiling() : 0.0f);
+    const float yCeil = (float) plot.getCentreY() - Decibels::decibelsToGain(shownCeilingDb) * ((float) plot.getHeight() * plotScale);
+    g.setColour(Colours::white.withAlpha(0.95f));
+    g.drawLine((float) plot.getX(), yCeil, (float) plot.getRight(), yCeil, 2.0f);
+}
+
+void ScopeComponent::drawColumns(const ScopeFrame* frames, int numFrames)
+{
+    const int w = wave.getWidth(), h = wave.getHeight();
+    const int n = jmin(numFrames, w);
+    frames += numFrames - n;
 
-    leftPath.clear(); rightPath.clear();
-    const int samples = buf.getNumSamples();
-    if (samples <= 0 || w <= 0) return;
+    // Scroll the existing columns left and clear the strip for the new ones.
+    if (n < w) wave.moveImageSection(0, 0, n, 0, w - n, h);
+    wave.clear({ w - n, 0, n, h });
 
-    const int step = jmax(1, samples / jmax(1, w));
-    auto drawChan = [&](int ch, Path& path)
+    Graphics g(wave);
+    const float midY  = (float) h * 0.5f;
+    const float scale = (float) h * plotScale;
+    const auto waveCol = Colour::fromRGB(255, 216, 0);
+    const Colour cols[2] = { waveCol.withAlpha(0.85f), waveCol.withAlpha(0.45f) };
+
+    // Peak over every channel behind the two drawn ones, so peaks on the
+    // rest of a surround bus still show.
+    g.setColour(Colours::white.withAlpha(0.15f));
+    for (int i = 0; i < n; ++i)
+    {
+        const float p = frames[i].peak * scale;
+        g.drawVerticalLine(w - n + i, midY - p, jmax(midY + p, midY - p + 1.0f));
+    }
+
+    for (int ch = 1; ch >= 0; --ch)
     {
-        float x = (float) bounds.getX();
-        bool started = false;
-        for (int i = 0; i < samples; i += step)
+        g.setColour(cols[ch]);
+        for (int i = 0; i < n; ++i)
         {
-            const float v = buf.getSample(jmin(ch, buf.getNumChannels()-1), i);
-            const float y = midY - v * (h * 0.40f);
-            if (!started) { path.startNewSubPath(x, y); started = true; }
-            else          { path.lineTo(x, y); }
-            x += 1.0f;
-            if (x > (float) bounds.getRight()) break;
+            const float top    = midY - frames[i].max[ch] * scale;
+            const float bottom = midY - frames[i].min[ch] * scale;
+            g.drawVerticalLine(w - n + i, top, jmax(bottom, top + 1.0f));
         }
-    };
-    drawChan(0, leftPath);
-    drawChan(1, rightPath);
+    }
+}
 
-    float ceilDb = getCeiling ? getCeiling() : 0.0f;
-    ceilDb = jlimit(-24.0f, 0.0f, ceilDb);
-    const float yCeil = midY - Decibels::decibelsToGain(ceilDb) * (h * 0.40f);
-    g.setColour(Colours::white.withAlpha(0.95f));
-    g.drawLine((float) bounds.getX(), yCeil, (float) bounds.getRight(), yCeil, 2.0f);
+void ScopeComponent::timerCallback()
+{
+    // Always drain the feed so the audio side never sees a full ring, but
+    // only draw and repaint when the scope can actually be seen.
+    const int n = readFn ? readFn(incoming.data(), (int) incoming.size()) : 0;
+    if (! isShowing() || ! wave.isValid()) return;
 
-    auto waveCol = Colour::fromRGB(255, 216, 0);
-    g.setColour(waveCol.withAlpha(0.25f));
-    g.strokePath(leftPath,  PathStrokeType(6.0f, PathStrokeType::beveled, PathStrokeType::rounded));
-    g.strokePath(rightPath, PathStrokeType(6.0f, PathStrokeType::beveled, PathStrokeType::rounded));
+    bool dirty = false;
+    const float ceilDb = jlimit(-24.0f, 0.0f, getCeiling ? getCeiling() : 0.0f);
+    if (ceilDb != shownCeilingDb) { renderStaticFrame(); dirty = true; }
+    if (n > 0) { drawColumns(incoming.data(), n); dirty = true; }
+
+    if (dirty) repaint();
+}
+
+void ScopeComponent::paint(juce::Graphics& g)
+{
+    if (! staticFrame.isValid()) { g.fillAll(Colour::fromFloatRGBA(0.07f, 0.08f, 0.10f, 1.0f)); return; }
 
-    g.setColour(waveCol);
-    g.strokePath(leftPath,  PathStrokeType(2.0f));
-    g.strokePath(rightPath, PathStrokeType(2.0f));
+    g.drawImageAt(staticFrame, 0, 0);
+    g.reduceClipRegion(plotClip);
+    g.drawImageAt(wave, plot.getX(), plot.getY());
 }
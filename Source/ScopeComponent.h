@@ -1,21 +1,34 @@
 #pragma once
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
+#include "ScopeFeed.h"
+#include <vector>
 
+// Scrolling min/max scope, over a faint band for the peak of all channels.
+// New frames are drawn as columns into an offscreen image that scrolls left,
+// so each update only touches the new columns. The
+// background, border and ceiling line live in a second cached image that is
+// rebuilt on resize or when the ceiling moves. The timer polls the feed and
+// only repaints when something changed and the scope is on screen.
 class ScopeComponent : public juce::Component, private juce::Timer
 {
 public:
-    ScopeComponent(std::function<void(juce::AudioBuffer<float>&)> reader,
+    ScopeComponent(std::function<int(ScopeFrame*, int)> reader,
                    std::function<float()> ceilingGetter);
     void paint(juce::Graphics& g) override;
-    void resized() override {}
+    void resized() override;
 
 private:
     void timerCallback() override;
+    void renderStaticFrame();
+    void drawColumns(const ScopeFrame* frames, int numFrames);
 
-    std::function<void(juce::AudioBuffer<float>&)> readFn;
+    std::function<int(ScopeFrame*, int)> readFn;
     std::function<float()> getCeiling;
 
-    juce::AudioBuffer<float> buf;
-    juce::Path leftPath, rightPath;
+    std::vector<ScopeFrame> incoming;
+    juce::Image staticFrame, wave;
+    juce::Rectangle<int> plot;
+    juce::Path plotClip;
+    float shownCeilingDb = 1.0f;
 };
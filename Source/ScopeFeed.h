@@ -0,0 +1,124 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "SimdOps.h"
+#include <array>
+#include <limits>
+
+// One scope column: the range of the first two channels over one bucket of
+// output samples, and the largest magnitude across every channel.
+struct ScopeFrame
+{
+    float min[2], max[2];
+    float peak;
+};
+
+// Decimates the output into ScopeFrames on the audio thread and hands them
+// to the GUI through a single-producer/single-consumer ring. Partial buckets
+// carry over between blocks, so frame boundaries don't depend on the host's
+// block size. The GUI draws one column per frame, so the scope scrolls at a
+// fixed framesPerSecond whatever the sample rate.
+class ScopeFeed
+{
+public:
+    static constexpr int capacity = 4096;
+    static constexpr double framesPerSecond = 3000.0;
+
+    void prepare(double sampleRate) noexcept
+    {
+        samplesPerFrame = juce::jmax(1, juce::roundToInt(sampleRate / framesPerSecond));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        fifo.reset();
+        pending = 0;
+        clearBucket();
+    }
+
+    int getSamplesPerFrame() const noexcept { return samplesPerFrame; }
+
+    // Audio thread. Frames that don't fit are dropped.
+    template <typename T>
+    void push(const T* const* data, int numChannels, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples;)
+        {
+            const int n = juce::jmin(samplesPerFrame - pending, numSamples - i);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                T lo, hi;
+                rangeOf(data[ch] + i, n, lo, hi);
+                bucket.peak = juce::jmax(bucket.peak, (float) -lo, (float) hi);
+                if (ch < 2)
+                {
+                    bucket.min[ch] = juce::jmin(bucket.min[ch], (float) lo);
+                    bucket.max[ch] = juce::jmax(bucket.max[ch], (float) hi);
+                }
+            }
+            i += n;
+            pending += n;
+
+            if (pending == samplesPerFrame)
+            {
+                if (numChannels == 1) { bucket.min[1] = bucket.min[0]; bucket.max[1] = bucket.max[0]; }
+                int start1, size1, start2, size2;
+                fifo.prepareToWrite(1, start1, size1, start2, size2);
+                if (size1 > 0)
+                {
+                    ring[(size_t) start1] = bucket;
+                    fifo.finishedWrite(1);
+                }
+                pending = 0;
+                clearBucket();
+            }
+        }
+    }
+
+    // GUI thread. Returns the number of frames copied, oldest first.
+    int read(ScopeFrame* dest, int maxFrames) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxFrames, start1, size1, start2, size2);
+        for (int i = 0; i < size1; ++i) dest[i]         = ring[(size_t) (start1 + i)];
+        for (int i = 0; i < size2; ++i) dest[size1 + i] = ring[(size_t) (start2 + i)];
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+private:
+    template <typename T>
+    static void rangeOf(const T* d, int n, T& lo, T& hi) noexcept
+    {
+        using V = typename SimdFor<T>::Wide;
+        int i = 0;
+        lo = hi = n > 0 ? d[0] : T(0);
+        if (n >= V::width)
+        {
+            V vlo = V::load(d), vhi = vlo;
+            for (i = V::width; i + V::width <= n; i += V::width)
+            {
+                const V x = V::load(d + i);
+                vlo = V::min(vlo, x);
+                vhi = V::max(vhi, x);
+            }
+            T l[V::width], h[V::width];
+            vlo.store(l);
+            vhi.store(h);
+            for (int k = 0; k < V::width; ++k) { lo = juce::jmin(lo, l[k]); hi = juce::jmax(hi, h[k]); }
+        }
+        for (; i < n; ++i) { lo = juce::jmin(lo, d[i]); hi = juce::jmax(hi, d[i]); }
+    }
+
+    void clearBucket() noexcept
+    {
+        bucket.min[0] = bucket.min[1] =  std::numeric_limits<float>::max();
+        bucket.max[0] = bucket.max[1] = -std::numeric_limits<float>::max();
+        bucket.peak = 0.0f;
+    }
+
+    juce::AbstractFifo fifo { capacity };
+    std::array<ScopeFrame, capacity> ring {};
+    ScopeFrame bucket {};
+    int samplesPerFrame = 16, pending = 0;
+};
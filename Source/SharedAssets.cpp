@@ -0,0 +1,21 @@
+#include "SharedAssets.h"
+#include "BinaryData.h"
+using namespace juce;
+
+SharedAssets::SharedAssets()
+    : background(ImageFileFormat::loadFrom(BinaryData::background_png, (size_t) BinaryData::background_pngSize))
+{
+}
+
+Image SharedAssets::getBackground(int width, int height, float scale)
+{
+    if (! background.isValid() || width <= 0 || height <= 0) return {};
+
+    const int w = roundToInt((float) width * scale), h = roundToInt((float) height * scale);
+    const auto key = std::make_tuple(w, h, roundToInt(scale * 100.0f));
+    if (auto it = scaled.find(key); it != scaled.end()) return it->second;
+
+    // Sizes rarely change, so a full cache just means a stale display setup.
+    if (scaled.size() >= maxScaledImages) scaled.clear();
+    return scaled[key] = background.rescaled(w, h, Graphics::highResamplingQuality);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <map>
+#include <tuple>
+
+// Editor assets shared by every ZClip instance in the process, held through
+// a juce::SharedResourcePointer so they live as long as any editor does.
+// The background is decoded once from the binary and rescaled once per
+// editor size and display scale, so paint() only blits it.
+class SharedAssets
+{
+public:
+    SharedAssets();
+
+    // Message thread only. The image is at physical pixel size: draw it
+    // into the component's logical bounds.
+    juce::Image getBackground(int width, int height, float scale);
+
+private:
+    static constexpr size_t maxScaledImages = 4;
+
+    juce::Image background;
+    std::map<std::tuple<int, int, int>, juce::Image> scaled;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedAssets)
+};
@@ -0,0 +1,432 @@
+#pragma once
+#include <cmath>
+
+#if defined(__AVX__)
+ #include <immintrin.h>
+ #define ZCLIP_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define ZCLIP_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define ZCLIP_SIMD_NEON 1
+#endif
+
+// Minimal float lane wrappers for the clip kernels. SimdF is the widest
+// register the build targets; ScalarF has the same interface and is used
+// for block tails and on targets without a vector unit.
+struct ScalarF
+{
+    using value_type = float;
+    static constexpr int width = 1;
+    float v;
+
+    static inline ScalarF load(const float* p) noexcept { return { *p }; }
+    static inline ScalarF set(float x) noexcept         { return { x }; }
+    inline void store(float* p) const noexcept           { *p = v; }
+
+    friend inline ScalarF operator+(ScalarF a, ScalarF b) noexcept { return { a.v + b.v }; }
+    friend inline ScalarF operator-(ScalarF a, ScalarF b) noexcept { return { a.v - b.v }; }
+    friend inline ScalarF operator*(ScalarF a, ScalarF b) noexcept { return { a.v * b.v }; }
+    friend inline ScalarF operator/(ScalarF a, ScalarF b) noexcept { return { a.v / b.v }; }
+
+    static inline ScalarF min(ScalarF a, ScalarF b) noexcept { return { b.v < a.v ? b.v : a.v }; }
+    static inline ScalarF max(ScalarF a, ScalarF b) noexcept { return { a.v < b.v ? b.v : a.v }; }
+    static inline ScalarF abs(ScalarF a) noexcept            { return { std::abs(a.v) }; }
+    static inline ScalarF copySign(ScalarF mag, ScalarF sgn) noexcept { return { std::copysign(mag.v, sgn.v) }; }
+    static inline int countGreater(ScalarF a, ScalarF b) noexcept     { return a.v > b.v ? 1 : 0; }
+};
+
+// Double-precision counterparts for the 64-bit processing path. Their load()
+// also accepts float pointers, widening on the fly, so control-rate data such
+// as parameter ramps and detector gains can stay in float.
+struct ScalarD
+{
+    using value_type = double;
+    static constexpr int width = 1;
+    double v;
+
+    static inline ScalarD load(const double* p) noexcept { return { *p }; }
+    static inline ScalarD load(const float* p) noexcept  { return { (double) *p }; }
+    static inline ScalarD set(double x) noexcept         { return { x }; }
+    inline void store(double* p) const noexcept           { *p = v; }
+
+    friend inline ScalarD operator+(ScalarD a, ScalarD b) noexcept { return { a.v + b.v }; }
+    friend inline ScalarD operator-(ScalarD a, ScalarD b) noexcept { return { a.v - b.v }; }
+    friend inline ScalarD operator*(ScalarD a, ScalarD b) noexcept { return { a.v * b.v }; }
+    friend inline ScalarD operator/(ScalarD a, ScalarD b) noexcept { return { a.v / b.v }; }
+
+    static inline ScalarD min(ScalarD a, ScalarD b) noexcept { return { b.v < a.v ? b.v : a.v }; }
+    static inline ScalarD max(ScalarD a, ScalarD b) noexcept { return { a.v < b.v ? b.v : a.v }; }
+    static inline ScalarD abs(ScalarD a) noexcept            { return { std::abs(a.v) }; }
+    static inline ScalarD copySign(ScalarD mag, ScalarD sgn) noexcept { return { std::copysign(mag.v, sgn.v) }; }
+    static inline int countGreater(ScalarD a, ScalarD b) noexcept     { return a.v > b.v ? 1 : 0; }
+};
+
+namespace simd_detail
+{
+    static inline int popCount8(int m) noexcept
+    {
+        m = m - ((m >> 1) & 0x55);
+        m = (m & 0x33) + ((m >> 2) & 0x33);
+        return (m + (m >> 4)) & 0x0F;
+    }
+}
+
+#if ZCLIP_SIMD_AVX
+struct SimdF
+{
+    using value_type = float;
+    static constexpr int width = 8;
+    __m256 v;
+
+    static inline SimdF load(const float* p) noexcept { return { _mm256_loadu_ps(p) }; }
+    static inline SimdF set(float x) noexcept         { return { _mm256_set1_ps(x) }; }
+    inline void store(float* p) const noexcept         { _mm256_storeu_ps(p, v); }
+
+    friend inline SimdF operator+(SimdF a, SimdF b) noexcept { return { _mm256_add_ps(a.v, b.v) }; }
+    friend inline SimdF operator-(SimdF a, SimdF b) noexcept { return { _mm256_sub_ps(a.v, b.v) }; }
+    friend inline SimdF operator*(SimdF a, SimdF b) noexcept { return { _mm256_mul_ps(a.v, b.v) }; }
+    friend inline SimdF operator/(SimdF a, SimdF b) noexcept { return { _mm256_div_ps(a.v, b.v) }; }
+
+    static inline SimdF min(SimdF a, SimdF b) noexcept { return { _mm256_min_ps(a.v, b.v) }; }
+    static inline SimdF max(SimdF a, SimdF b) noexcept { return { _mm256_max_ps(a.v, b.v) }; }
+    static inline SimdF abs(SimdF a) noexcept          { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+    static inline SimdF copySign(SimdF mag, SimdF sgn) noexcept
+    {
+        const __m256 sm = _mm256_set1_ps(-0.0f);
+        return { _mm256_or_ps(_mm256_andnot_ps(sm, mag.v), _mm256_and_ps(sm, sgn.v)) };
+    }
+    static inline int countGreater(SimdF a, SimdF b) noexcept
+    {
+        return simd_detail::popCount8(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)));
+    }
+};
+#elif ZCLIP_SIMD_SSE2
+struct SimdF
+{
+    using value_type = float;
+    static constexpr int width = 4;
+    __m128 v;
+
+    static inline SimdF load(const float* p) noexcept { return { _mm_loadu_ps(p) }; }
+    static inline SimdF set(float x) noexcept         { return { _mm_set1_ps(x) }; }
+    inline void store(float* p) const noexcept         { _mm_storeu_ps(p, v); }
+
+    friend inline SimdF operator+(SimdF a, SimdF b) noexcept { return { _mm_add_ps(a.v, b.v) }; }
+    friend inline SimdF operator-(SimdF a, SimdF b) noexcept { return { _mm_sub_ps(a.v, b.v) }; }
+    friend inline SimdF operator*(SimdF a, SimdF b) noexcept { return { _mm_mul_ps(a.v, b.v) }; }
+    friend inline SimdF operator/(SimdF a, SimdF b) noexcept { return { _mm_div_ps(a.v, b.v) }; }
+
+    static inline SimdF min(SimdF a, SimdF b) noexcept { return { _mm_min_ps(a.v, b.v) }; }
+    static inline SimdF max(SimdF a, SimdF b) noexcept { return { _mm_max_ps(a.v, b.v) }; }
+    static inline SimdF abs(SimdF a) noexcept          { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+    static inline SimdF copySign(SimdF mag, SimdF sgn) noexcept
+    {
+        const __m128 sm = _mm_set1_ps(-0.0f);
+        return { _mm_or_ps(_mm_andnot_ps(sm, mag.v), _mm_and_ps(sm, sgn.v)) };
+    }
+    static inline int countGreater(SimdF a, SimdF b) noexcept
+    {
+        return simd_detail::popCount8(_mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)));
+    }
+};
+#elif ZCLIP_SIMD_NEON
+struct SimdF
+{
+    using value_type = float;
+    static constexpr int width = 4;
+    float32x4_t v;
+
+    static inline SimdF load(const float* p) noexcept { return { vld1q_f32(p) }; }
+    static inline SimdF set(float x) noexcept         { return { vdupq_n_f32(x) }; }
+    inline void store(float* p) const noexcept         { vst1q_f32(p, v); }
+
+    friend inline SimdF operator+(SimdF a, SimdF b) noexcept { return { vaddq_f32(a.v, b.v) }; }
+    friend inline SimdF operator-(SimdF a, SimdF b) noexcept { return { vsubq_f32(a.v, b.v) }; }
+    friend inline SimdF operator*(SimdF a, SimdF b) noexcept { return { vmulq_f32(a.v, b.v) }; }
+    friend inline SimdF operator/(SimdF a, SimdF b) noexcept
+    {
+       #if defined(__aarch64__) || defined(_M_ARM64)
+        return { vdivq_f32(a.v, b.v) };
+       #else
+        float32x4_t r = vrecpeq_f32(b.v);
+        r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+        r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+        return { vmulq_f32(a.v, r) };
+       #endif
+    }
+
+    static inline SimdF min(SimdF a, SimdF b) noexcept { return { vminq_f32(a.v, b.v) }; }
+    static inline SimdF max(SimdF a, SimdF b) noexcept { return { vmaxq_f32(a.v, b.v) }; }
+    static inline SimdF abs(SimdF a) noexcept          { return { vabsq_f32(a.v) }; }
+    static inline SimdF copySign(SimdF mag, SimdF sgn) noexcept
+    {
+        return { vbslq_f32(vdupq_n_u32(0x80000000u), sgn.v, mag.v) };
+    }
+    static inline int countGreater(SimdF a, SimdF b) noexcept
+    {
+        const uint32x4_t c = vshrq_n_u32(vcgtq_f32(a.v, b.v), 31);
+        const uint32x2_t s = vadd_u32(vget_low_u32(c), vget_high_u32(c));
+        return (int) (vget_lane_u32(s, 0) + vget_lane_u32(s, 1));
+    }
+};
+#else
+using SimdF = ScalarF;
+#endif
+
+// Fixed four-lane float vector for kernels whose lane count is set by the
+// algorithm (polyphase FIR phases) rather than by the register width.
+#if ZCLIP_SIMD_AVX || ZCLIP_SIMD_SSE2
+struct Vec4F
+{
+    using value_type = float;
+    __m128 v;
+
+    static inline Vec4F load(const float* p) noexcept { return { _mm_loadu_ps(p) }; }
+    static inline Vec4F set(float x) noexcept         { return { _mm_set1_ps(x) }; }
+    inline void store(float* p) const noexcept         { _mm_storeu_ps(p, v); }
+
+    friend inline Vec4F operator+(Vec4F a, Vec4F b) noexcept { return { _mm_add_ps(a.v, b.v) }; }
+    friend inline Vec4F operator-(Vec4F a, Vec4F b) noexcept { return { _mm_sub_ps(a.v, b.v) }; }
+    friend inline Vec4F operator*(Vec4F a, Vec4F b) noexcept { return { _mm_mul_ps(a.v, b.v) }; }
+
+    static inline Vec4F min(Vec4F a, Vec4F b) noexcept { return { _mm_min_ps(a.v, b.v) }; }
+    static inline Vec4F max(Vec4F a, Vec4F b) noexcept { return { _mm_max_ps(a.v, b.v) }; }
+    static inline Vec4F abs(Vec4F a) noexcept          { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+    static inline Vec4F copySign(Vec4F mag, Vec4F sgn) noexcept
+    {
+        const __m128 sm = _mm_set1_ps(-0.0f);
+        return { _mm_or_ps(_mm_andnot_ps(sm, mag.v), _mm_and_ps(sm, sgn.v)) };
+    }
+    inline float sumLanes() const noexcept
+    {
+        const __m128 s = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+    inline float maxLane() const noexcept
+    {
+        const __m128 m = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+};
+#elif ZCLIP_SIMD_NEON
+struct Vec4F
+{
+    using value_type = float;
+    float32x4_t v;
+
+    static inline Vec4F load(const float* p) noexcept { return { vld1q_f32(p) }; }
+    static inline Vec4F set(float x) noexcept         { return { vdupq_n_f32(x) }; }
+    inline void store(float* p) const noexcept         { vst1q_f32(p, v); }
+
+    friend inline Vec4F operator+(Vec4F a, Vec4F b) noexcept { return { vaddq_f32(a.v, b.v) }; }
+    friend inline Vec4F operator-(Vec4F a, Vec4F b) noexcept { return { vsubq_f32(a.v, b.v) }; }
+    friend inline Vec4F operator*(Vec4F a, Vec4F b) noexcept { return { vmulq_f32(a.v, b.v) }; }
+
+    static inline Vec4F min(Vec4F a, Vec4F b) noexcept { return { vminq_f32(a.v, b.v) }; }
+    static inline Vec4F max(Vec4F a, Vec4F b) noexcept { return { vmaxq_f32(a.v, b.v) }; }
+    static inline Vec4F abs(Vec4F a) noexcept          { return { vabsq_f32(a.v) }; }
+    static inline Vec4F copySign(Vec4F mag, Vec4F sgn) noexcept
+    {
+        return { vbslq_f32(vdupq_n_u32(0x80000000u), sgn.v, mag.v) };
+    }
+    inline float sumLanes() const noexcept
+    {
+        const float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpadd_f32(s, s), 0);
+    }
+    inline float maxLane() const noexcept
+    {
+        const float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpmax_f32(m, m), 0);
+    }
+};
+#endif
+
+// Four lanes in a plain array, for targets without a matching register;
+// the compiler is left to vectorise the lane loops.
+template <typename T>
+struct Vec4Array
+{
+    using value_type = T;
+    T v[4];
+
+    static inline Vec4Array load(const T* p) noexcept { return { { p[0], p[1], p[2], p[3] } }; }
+    static inline Vec4Array set(T x) noexcept         { return { { x, x, x, x } }; }
+    inline void store(T* p) const noexcept            { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+
+    template <typename Op>
+    static inline Vec4Array map(Vec4Array a, Vec4Array b, Op op) noexcept
+    {
+        return { { op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3]) } };
+    }
+    friend inline Vec4Array operator+(Vec4Array a, Vec4Array b) noexcept { return map(a, b, [](T x, T y) { return x + y; }); }
+    friend inline Vec4Array operator-(Vec4Array a, Vec4Array b) noexcept { return map(a, b, [](T x, T y) { return x - y; }); }
+    friend inline Vec4Array operator*(Vec4Array a, Vec4Array b) noexcept { return map(a, b, [](T x, T y) { return x * y; }); }
+
+    static inline Vec4Array min(Vec4Array a, Vec4Array b) noexcept { return map(a, b, [](T x, T y) { return y < x ? y : x; }); }
+    static inline Vec4Array max(Vec4Array a, Vec4Array b) noexcept { return map(a, b, [](T x, T y) { return x < y ? y : x; }); }
+    static inline Vec4Array abs(Vec4Array a) noexcept              { return map(a, a, [](T x, T) { return std::abs(x); }); }
+    static inline Vec4Array copySign(Vec4Array mag, Vec4Array sgn) noexcept { return map(mag, sgn, [](T x, T y) { return std::copysign(x, y); }); }
+    inline T sumLanes() const noexcept { return (v[0] + v[1]) + (v[2] + v[3]); }
+    inline T maxLane() const noexcept
+    {
+        const T m0 = v[0] < v[1] ? v[1] : v[0], m1 = v[2] < v[3] ? v[3] : v[2];
+        return m0 < m1 ? m1 : m0;
+    }
+};
+
+#if ! (ZCLIP_SIMD_AVX || ZCLIP_SIMD_SSE2 || ZCLIP_SIMD_NEON)
+using Vec4F = Vec4Array<float>;
+#endif
+
+
+#if ZCLIP_SIMD_AVX
+struct SimdD
+{
+    using value_type = double;
+    static constexpr int width = 4;
+    __m256d v;
+
+    static inline SimdD load(const double* p) noexcept { return { _mm256_loadu_pd(p) }; }
+    static inline SimdD load(const float* p) noexcept  { return { _mm256_cvtps_pd(_mm_loadu_ps(p)) }; }
+    static inline SimdD set(double x) noexcept         { return { _mm256_set1_pd(x) }; }
+    inline void store(double* p) const noexcept         { _mm256_storeu_pd(p, v); }
+
+    friend inline SimdD operator+(SimdD a, SimdD b) noexcept { return { _mm256_add_pd(a.v, b.v) }; }
+    friend inline SimdD operator-(SimdD a, SimdD b) noexcept { return { _mm256_sub_pd(a.v, b.v) }; }
+    friend inline SimdD operator*(SimdD a, SimdD b) noexcept { return { _mm256_mul_pd(a.v, b.v) }; }
+    friend inline SimdD operator/(SimdD a, SimdD b) noexcept { return { _mm256_div_pd(a.v, b.v) }; }
+
+    static inline SimdD min(SimdD a, SimdD b) noexcept { return { _mm256_min_pd(a.v, b.v) }; }
+    static inline SimdD max(SimdD a, SimdD b) noexcept { return { _mm256_max_pd(a.v, b.v) }; }
+    static inline SimdD abs(SimdD a) noexcept          { return { _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v) }; }
+    static inline SimdD copySign(SimdD mag, SimdD sgn) noexcept
+    {
+        const __m256d sm = _mm256_set1_pd(-0.0);
+        return { _mm256_or_pd(_mm256_andnot_pd(sm, mag.v), _mm256_and_pd(sm, sgn.v)) };
+    }
+    static inline int countGreater(SimdD a, SimdD b) noexcept
+    {
+        return simd_detail::popCount8(_mm256_movemask_pd(_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)));
+    }
+};
+
+struct Vec4D
+{
+    using value_type = double;
+    __m256d v;
+
+    static inline Vec4D load(const double* p) noexcept { return { _mm256_loadu_pd(p) }; }
+    static inline Vec4D set(double x) noexcept         { return { _mm256_set1_pd(x) }; }
+    inline void store(double* p) const noexcept         { _mm256_storeu_pd(p, v); }
+
+    friend inline Vec4D operator+(Vec4D a, Vec4D b) noexcept { return { _mm256_add_pd(a.v, b.v) }; }
+    friend inline Vec4D operator-(Vec4D a, Vec4D b) noexcept { return { _mm256_sub_pd(a.v, b.v) }; }
+    friend inline Vec4D operator*(Vec4D a, Vec4D b) noexcept { return { _mm256_mul_pd(a.v, b.v) }; }
+
+    static inline Vec4D min(Vec4D a, Vec4D b) noexcept { return { _mm256_min_pd(a.v, b.v) }; }
+    static inline Vec4D max(Vec4D a, Vec4D b) noexcept { return { _mm256_max_pd(a.v, b.v) }; }
+    static inline Vec4D abs(Vec4D a) noexcept          { return { _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v) }; }
+    static inline Vec4D copySign(Vec4D mag, Vec4D sgn) noexcept
+    {
+        const __m256d sm = _mm256_set1_pd(-0.0);
+        return { _mm256_or_pd(_mm256_andnot_pd(sm, mag.v), _mm256_and_pd(sm, sgn.v)) };
+    }
+    inline double sumLanes() const noexcept
+    {
+        const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    }
+    inline double maxLane() const noexcept
+    {
+        const __m128d m = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+    }
+};
+#elif ZCLIP_SIMD_SSE2
+struct SimdD
+{
+    using value_type = double;
+    static constexpr int width = 2;
+    __m128d v;
+
+    static inline SimdD load(const double* p) noexcept { return { _mm_loadu_pd(p) }; }
+    static inline SimdD load(const float* p) noexcept  { return { _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*) p))) }; }
+    static inline SimdD set(double x) noexcept         { return { _mm_set1_pd(x) }; }
+    inline void store(double* p) const noexcept         { _mm_storeu_pd(p, v); }
+
+    friend inline SimdD operator+(SimdD a, SimdD b) noexcept { return { _mm_add_pd(a.v, b.v) }; }
+    friend inline SimdD operator-(SimdD a, SimdD b) noexcept { return { _mm_sub_pd(a.v, b.v) }; }
+    friend inline SimdD operator*(SimdD a, SimdD b) noexcept { return { _mm_mul_pd(a.v, b.v) }; }
+    friend inline SimdD operator/(SimdD a, SimdD b) noexcept { return { _mm_div_pd(a.v, b.v) }; }
+
+    static inline SimdD min(SimdD a, SimdD b) noexcept { return { _mm_min_pd(a.v, b.v) }; }
+    static inline SimdD max(SimdD a, SimdD b) noexcept { return { _mm_max_pd(a.v, b.v) }; }
+    static inline SimdD abs(SimdD a) noexcept          { return { _mm_andnot_pd(_mm_set1_pd(-0.0), a.v) }; }
+    static inline SimdD copySign(SimdD mag, SimdD sgn) noexcept
+    {
+        const __m128d sm = _mm_set1_pd(-0.0);
+        return { _mm_or_pd(_mm_andnot_pd(sm, mag.v), _mm_and_pd(sm, sgn.v)) };
+    }
+    static inline int countGreater(SimdD a, SimdD b) noexcept
+    {
+        return simd_detail::popCount8(_mm_movemask_pd(_mm_cmpgt_pd(a.v, b.v)));
+    }
+};
+using Vec4D = Vec4Array<double>;
+#elif ZCLIP_SIMD_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+struct SimdD
+{
+    using value_type = double;
+    static constexpr int width = 2;
+    float64x2_t v;
+
+    static inline SimdD load(const double* p) noexcept { return { vld1q_f64(p) }; }
+    static inline SimdD load(const float* p) noexcept  { return { vcvt_f64_f32(vld1_f32(p)) }; }
+    static inline SimdD set(double x) noexcept         { return { vdupq_n_f64(x) }; }
+    inline void store(double* p) const noexcept         { vst1q_f64(p, v); }
+
+    friend inline SimdD operator+(SimdD a, SimdD b) noexcept { return { vaddq_f64(a.v, b.v) }; }
+    friend inline SimdD operator-(SimdD a, SimdD b) noexcept { return { vsubq_f64(a.v, b.v) }; }
+    friend inline SimdD operator*(SimdD a, SimdD b) noexcept { return { vmulq_f64(a.v, b.v) }; }
+    friend inline SimdD operator/(SimdD a, SimdD b) noexcept { return { vdivq_f64(a.v, b.v) }; }
+
+    static inline SimdD min(SimdD a, SimdD b) noexcept { return { vminq_f64(a.v, b.v) }; }
+    static inline SimdD max(SimdD a, SimdD b) noexcept { return { vmaxq_f64(a.v, b.v) }; }
+    static inline SimdD abs(SimdD a) noexcept          { return { vabsq_f64(a.v) }; }
+    static inline SimdD copySign(SimdD mag, SimdD sgn) noexcept
+    {
+        return { vbslq_f64(vdupq_n_u64(0x8000000000000000ull), sgn.v, mag.v) };
+    }
+    static inline int countGreater(SimdD a, SimdD b) noexcept
+    {
+        const uint64x2_t c = vshrq_n_u64(vcgtq_f64(a.v, b.v), 63);
+        return (int) (vgetq_lane_u64(c, 0) + vgetq_lane_u64(c, 1));
+    }
+};
+using Vec4D = Vec4Array<double>;
+#else
+using SimdD = ScalarD;
+using Vec4D = Vec4Array<double>;
+#endif
+
+// Lane types by sample type, for kernels templated on float or double.
+template <typename T> struct SimdFor;
+template <> struct SimdFor<float>  { using Wide = SimdF; using Scalar = ScalarF; using Quad = Vec4F; };
+template <> struct SimdFor<double> { using Wide = SimdD; using Scalar = ScalarD; using Quad = Vec4D; };
+
+// True when no |d[i]| exceeds `floor`. Stops at the first vector above it.
+template <typename T>
+inline bool peakBelow(const T* d, int n, T floor) noexcept
+{
+    using V = typename SimdFor<T>::Wide;
+    const V f = V::set(floor);
+    int i = 0;
+    for (; i + V::width <= n; i += V::width)
+        if (V::countGreater(V::abs(V::load(d + i)), f) != 0) return false;
+    for (; i < n; ++i)
+        if (std::abs(d[i]) > floor) return false;
+    return true;
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include "SimdOps.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// ITU-R BS.1770 true-peak estimate (4x polyphase FIR, 12 taps per phase)
+// driving a lookahead peak limiter. The four phases of one input sample are
+// computed together in the lanes of a Vec4F.
+class TruePeakDetector
+{
+public:
+    static constexpr int taps = 12;
+
+    // Output of process() describes the signal between x[n-6] and x[n-5].
+    static constexpr int delay = 6;
+
+    void prepare(int numChannels)
+    {
+        history.assign((size_t) numChannels * 2 * taps, 0.0f);
+        pos.assign((size_t) numChannels, 0);
+    }
+
+    void reset()
+    {
+        std::fill(history.begin(), history.end(), 0.0f);
+        std::fill(pos.begin(), pos.end(), 0);
+    }
+
+    inline float process(int ch, float x) noexcept
+    {
+        float* h = history.data() + (size_t) ch * 2 * taps;
+        int& p = pos[(size_t) ch];
+        p = (p == 0 ? taps : p) - 1;
+        h[p] = h[p + taps] = x;
+
+        const float* w = h + p;
+        Vec4F acc = Vec4F::set(0.0f);
+        for (int k = 0; k < taps; ++k)
+            acc = acc + Vec4F::load(coeffs[k]) * Vec4F::set(w[k]);
+        const float s = std::abs(w[delay]);
+        const float i = Vec4F::abs(acc).maxLane();
+        return i > s ? i : s;
+    }
+
+private:
+    // BS.1770-4 Annex 2 interpolation filter, transposed to [tap][phase].
+    static constexpr float coeffs[taps][4] =
+    {
+        {  0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+        {  0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f },
+        { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+        {  0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f },
+        { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+        {  0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f },
+        {  0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f },
+        { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+        {  0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f },
+        { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+        {  0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f },
+        { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f }
+    };
+
+    std::vector<float> history;
+    std::vector<int> pos;
+};
+
+// Linked lookahead limiter on the true-peak estimate. The required gain is
+// held for window + 3 samples and then box-averaged over window samples, so
+// the applied gain has reached every detected peak's gain before that
+// peak's samples leave the delay line. A final clamp catches sample peaks
+// left over from float rounding. Audio and the delay line are float or
+// double; detection and gain run in float. The delay line also runs while
+// limiting is off, so the toggle changes only the gain, never the latency:
+// off, nothing is detected and the gain releases back to 1; switching on
+// first runs detection over what is already in the delay line.
+template <typename T>
+class TruePeakLimiter
+{
+public:
+    void prepare(double sampleRate, int numChannels, double lookaheadMs = 1.5, double releaseMs = 60.0)
+    {
+        channels = std::max(1, numChannels);
+        window   = std::max(1, (int) std::lround(sampleRate * lookaheadMs * 0.001));
+        hold     = window + 3;
+        delay    = window + TruePeakDetector::delay;
+        relCoef  = (float) std::exp(-1.0 / (sampleRate * releaseMs * 0.001));
+
+        detector.prepare(channels);
+        delayLine.assign((size_t) channels * (size_t) delay, T(0));
+        box.assign((size_t) window, 1.0f);
+        minIdx.assign((size_t) hold + 1, 0);
+        minVal.assign((size_t) hold + 1, 1.0f);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(delayLine.begin(), delayLine.end(), T(0));
+        delayPos = 0;
+        resetGain();
+    }
+
+    int getLatencySamples() const noexcept { return delay; }
+
+    // Smallest gain applied since the last call; 1 means no limiting.
+    float takeMinGain() noexcept { const float g = minGain; minGain = 1.0f; return g; }
+
+    void process(T* const* data, int numChannels, int startSample, int numSamples, float ceiling, bool limit) noexcept
+    {
+        const int nch = std::min(numChannels, channels);
+        if (limit && ! primed) prime(nch, ceiling);
+        primed = limit;
+
+        for (int i = startSample; i < startSample + numSamples; ++i)
+        {
+            float need = 1.0f;
+            if (limit)
+            {
+                float peak = 0.0f;
+                for (int ch = 0; ch < nch; ++ch)
+                    peak = std::max(peak, detector.process(ch, (float) data[ch][i]));
+                need = peak > ceiling ? ceiling / peak : 1.0f;
+            }
+            const float g = updateGain(need);
+            minGain = std::min(minGain, g);
+
+            const T c = limit ? (T) ceiling : std::numeric_limits<T>::max();
+            for (int ch = 0; ch < nch; ++ch)
+            {
+                T& slot = delayLine[(size_t) ch * (size_t) delay + (size_t) delayPos];
+                const T y = slot * (T) g;
+                slot = data[ch][i];
+                data[ch][i] = y < -c ? -c : (y > c ? c : y);
+            }
+            if (++delayPos == delay) delayPos = 0;
+        }
+    }
+
+private:
+    void resetGain() noexcept
+    {
+        detector.reset();
+        std::fill(box.begin(), box.end(), 1.0f);
+        boxSum = (double) window;
+        boxPos = 0;
+        minHead = minCount = 0;
+        time = 0;
+        release = 1.0f;
+        minGain = 1.0f;
+        primed = false;
+    }
+
+    // Held, released and box-averaged gain for one sample's required gain.
+    inline float updateGain(float need) noexcept
+    {
+        const float held = slidingMin(need);
+        release = held < release ? held : held + relCoef * (release - held);
+
+        boxSum += (double) (release - box[(size_t) boxPos]);
+        box[(size_t) boxPos] = release;
+        if (++boxPos == window) boxPos = 0;
+        return std::min(1.0f, (float) boxSum / (float) window);
+    }
+
+    // Runs detection and gain over the delay line's contents, oldest first,
+    // at the times they were written, so the samples about to leave it are
+    // limited as if the limiter had been on.
+    void prime(int nch, float ceiling) noexcept
+    {
+        resetGain();
+        for (int k = 0, p = delayPos; k < delay; ++k, p = (p + 1 == delay ? 0 : p + 1))
+        {
+            float peak = 0.0f;
+            for (int ch = 0; ch < nch; ++ch)
+                peak = std::max(peak, detector.process(ch, (float) delayLine[(size_t) ch * (size_t) delay + (size_t) p]));
+            updateGain(peak > ceiling ? ceiling / peak : 1.0f);
+        }
+    }
+
+    // Monotonic deque over the last `hold` required gains.
+    inline float slidingMin(float v) noexcept
+    {
+        const int cap = hold + 1;
+        while (minCount > 0)
+        {
+            const int back = (minHead + minCount - 1) % cap;
+            if (minVal[(size_t) back] < v) break;
+            --minCount;
+        }
+        const int slot = (minHead + minCount) % cap;
+        minIdx[(size_t) slot] = time;
+        minVal[(size_t) slot] = v;
+        ++minCount;
+
+        while (minIdx[(size_t) minHead] <= time - hold) { minHead = (minHead + 1) % cap; --minCount; }
+        ++time;
+        return minVal[(size_t) minHead];
+    }
+
+    TruePeakDetector detector;
+    int channels = 1, window = 1, hold = 4, delay = 7;
+    float relCoef = 0.0f, release = 1.0f, minGain = 1.0f;
+    bool primed = false;
+
+    std::vector<T> delayLine;
+    std::vector<float> box, minVal;
+    std::vector<long long> minIdx;
+    double boxSum = 1.0;
+    int boxPos = 0, delayPos = 0, minHead = 0, minCount = 0;
+    long long time = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Upward-compression envelope followers and gain curve for a bank of
+// channels. Coefficients are computed once per rate change. Envelope state
+// is kept structure-of-arrays (one float per channel) and processFrame is
+// branch-free across channels so the channel loop maps onto SIMD lanes.
+class UpwardDetector
+{
+public:
+    static constexpr int maxChannels = 16;
+
+    void prepare(double rate, float attackSec, float releaseSec) noexcept
+    {
+        atk = std::exp(-1.0f / (float) (rate * (double) attackSec));
+        rel = std::exp(-1.0f / (float) (rate * (double) releaseSec));
+    }
+
+    void setCurve(float ceilLin, float upMaxLin, float kneeDb) noexcept
+    {
+        invCeil = 1.0f / (ceilLin > 1.0e-6f ? ceilLin : 1.0e-6f);
+        depth   = upMaxLin - 1.0f;
+
+        // A hard knee is approximated by a 0.01 dB one so the curve stays a
+        // log plus a clamp and needs no per-channel branch.
+        const float knee = kneeDb > 0.01f ? kneeDb : 0.01f;
+        kneeScale = dBPerOctave / knee;
+    }
+
+    // Updates env[0..numCh) from the rectified levels ax[] and writes each
+    // channel's gain: 1 + depth * clamp(-envDb / knee, 0, 1), with envDb
+    // relative to the ceiling.
+    inline void processFrame(const float* ax, float* env, float* gain, int numCh) const noexcept
+    {
+        for (int c = 0; c < numCh; ++c)
+        {
+            const float a = ax[c], e = env[c];
+            const float next = a + ((a > e) ? atk : rel) * (e - a);
+            env[c] = next;
+
+            float k = -kneeScale * fastLog2(next * invCeil);
+            k = k < 0.0f ? 0.0f : (k > 1.0f ? 1.0f : k);
+            gain[c] = 1.0f + depth * k;
+        }
+    }
+
+    static inline float fastLog2(float x) noexcept
+    {
+        uint32_t bits; std::memcpy(&bits, &x, sizeof(bits));
+        const float e = (float) ((int) ((bits >> 23) & 0xFFu) - 127);
+        bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+        float m; std::memcpy(&m, &bits, sizeof(m));
+        return e + (((0.15638611f * m - 1.04640899f) * m + 3.04452418f) * m - 2.15450130f);
+    }
+
+private:
+    static constexpr float dBPerOctave = 6.0205999f;
+    float atk = 0.0f, rel = 0.0f;
+    float invCeil = 1.0f, depth = 0.0f, kneeScale = 0.0f;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdio>
+
+// Shared by the test programs: each failed expectation is printed, and
+// finish() turns the count into the exit code ctest reads.
+namespace check
+{
+inline int failures = 0;
+
+inline void expect(bool ok, const char* what)
+{
+    if (! ok) { std::printf("FAIL: %s\n", what); ++failures; }
+}
+
+inline int finish()
+{
+    if (failures == 0) std::printf("all passed\n");
+    return failures == 0 ? 0 : 1;
+}
+}
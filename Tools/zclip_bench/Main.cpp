@@ -0,0 +1,295 @@
+#include <juce_audio_utils/juce_audio_utils.h>
+#include "PluginProcessor.h"
+#include <chrono>
+#include <iostream>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+ #include <intrin.h>
+ #define ZCLIP_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+ #define ZCLIP_HAS_TSC 1
+#else
+ #define ZCLIP_HAS_TSC 0
+#endif
+using namespace juce;
+
+namespace
+{
+struct Config
+{
+    int os = 0, osFilter = 1, clipMode = 0, bands = 0, blockSize = 512, channels = 2;
+    bool adaptive = false, doublePrecision = false;
+    bool up = false, isp = false, dryMix = false;
+};
+
+struct Measurement
+{
+    double nsPerSample = 0.0, cyclesPerSample = -1.0, worstBlockUs = 0.0, realtimeInstances = 0.0;
+};
+
+inline uint64 readCycleCounter() noexcept
+{
+   #if ZCLIP_HAS_TSC
+    return (uint64) __rdtsc();
+   #else
+    return 0;
+   #endif
+}
+
+void setParam(ZClipAudioProcessor& proc, const String& id, float value)
+{
+    if (auto* p = proc.apvts.getParameter(id))
+        p->setValueNotifyingHost(p->convertTo0to1(value));
+}
+
+// Loud programme-like test signal: two detuned partials plus noise, hot
+// enough at +6 dB pregain that the clipper and the upward detector both work.
+AudioBuffer<float> makeSignal(int channels, int length, double sr)
+{
+    AudioBuffer<float> sig(channels, length);
+    Random rng(0x5a17);
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        float* d = sig.getWritePointer(ch);
+        for (int i = 0; i < length; ++i)
+        {
+            const double t = (double) i / sr;
+            d[i] = (float) (0.45 * std::sin(MathConstants<double>::twoPi * (110.0 + 3.0 * ch) * t)
+                          + 0.25 * std::sin(MathConstants<double>::twoPi * 2750.0 * t)
+                          + 0.15 * (rng.nextDouble() * 2.0 - 1.0));
+        }
+    }
+    return sig;
+}
+
+String configName(const Config& c)
+{
+    return "os" + String(1 << c.os) + "_bs" + String(c.blockSize) + "_ch" + String(c.channels)
+         + (c.up ? "_up" : "") + (c.isp ? "_isp" : "") + (c.dryMix ? "_mix50" : "");
+}
+
+// With profileDir set, each configuration's stage timings over the timed
+// blocks are written there (needs a ZCLIP_PROFILE build).
+template <typename T>
+Measurement runAs(const Config& c, double sr, double seconds, const File& profileDir)
+{
+    ZClipAudioProcessor proc;
+    if constexpr (std::is_same_v<T, double>)
+        proc.setProcessingPrecision(AudioProcessor::doublePrecision);
+
+    const auto set = c.channels == 12 ? AudioChannelSet::create7point1point4()
+                                      : AudioChannelSet::canonicalChannelSet(c.channels);
+    AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(set);
+    layout.outputBuses.add(set);
+    proc.setBusesLayout(layout);
+
+    setParam(proc, "os",        (float) c.os);
+    setParam(proc, "os_filter", (float) c.osFilter);
+    setParam(proc, "os_adaptive", c.adaptive ? 1.0f : 0.0f);
+    setParam(proc, "clip_mode", (float) c.clipMode);
+    setParam(proc, "mb_bands",  (float) (c.bands > 1 ? c.bands - 1 : 0));
+    setParam(proc, "up_enable", c.up ? 1.0f : 0.0f);
+    setParam(proc, "up_amount", 4.0f);
+    setParam(proc, "isp",       c.isp ? 1.0f : 0.0f);
+    setParam(proc, "mix",       c.dryMix ? 50.0f : 100.0f);
+    setParam(proc, "pregain",   6.0f);
+    setParam(proc, "ceiling",  -1.0f);
+
+    proc.setRateAndBufferSizeDetails(sr, c.blockSize);
+    proc.prepareToPlay(sr, c.blockSize);
+
+    const int sigLen = (int) sr;
+    const auto signal = makeSignal(c.channels, sigLen, sr);
+    AudioBuffer<T> work(c.channels, c.blockSize);
+    MidiBuffer midi;
+
+    const int warmupBlocks = jmax(4, (int) (0.1 * sr) / c.blockSize);
+    const int timedBlocks  = jmax(16, (int) (seconds * sr) / c.blockSize);
+
+    int pos = 0;
+    auto fill = [&]
+    {
+        for (int ch = 0; ch < c.channels; ++ch)
+            for (int i = 0, p = pos; i < c.blockSize; ++i, p = (p + 1 == sigLen ? 0 : p + 1))
+                work.setSample(ch, i, (T) signal.getSample(ch, p));
+        pos = (pos + c.blockSize) % sigLen;
+    };
+
+    ProfileStats profile;
+    ProfileRecord records[64];
+    auto drainProfile = [&](bool keep)
+    {
+        for (int n; (n = proc.readProfile(records, 64)) > 0;)
+            for (int i = 0; keep && i < n; ++i) profile.add(records[i]);
+    };
+
+    for (int b = 0; b < warmupBlocks; ++b) { fill(); proc.processBlock(work, midi); }
+    drainProfile(false);
+
+    using Clock = std::chrono::steady_clock;
+    double totalNs = 0.0, worstNs = 0.0;
+    uint64 totalCycles = 0;
+    for (int b = 0; b < timedBlocks; ++b)
+    {
+        fill();
+        const uint64 c0 = readCycleCounter();
+        const auto   t0 = Clock::now();
+        proc.processBlock(work, midi);
+        const auto   t1 = Clock::now();
+        const uint64 c1 = readCycleCounter();
+
+        const double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        totalNs += ns;
+        worstNs  = jmax(worstNs, ns);
+        totalCycles += c1 - c0;
+        drainProfile(true);
+    }
+    proc.releaseResources();
+
+    if (profileDir != File() && ! profile.dump(profileDir.getChildFile(configName(c) + ".txt"), proc.getProfileDropped()))
+        std::cerr << "cannot write profile to " << profileDir.getFullPathName() << "\n";
+
+    const double frames  = (double) timedBlocks * c.blockSize;
+    const double samples = frames * c.channels;
+
+    Measurement m;
+    m.nsPerSample       = totalNs / samples;
+    m.cyclesPerSample   = ZCLIP_HAS_TSC ? (double) totalCycles / samples : -1.0;
+    m.worstBlockUs      = worstNs * 0.001;
+    m.realtimeInstances = (frames / sr * 1.0e9) / jmax(1.0, totalNs);
+    return m;
+}
+
+Measurement run(const Config& c, double sr, double seconds, const File& profileDir)
+{
+    return c.doublePrecision ? runAs<double>(c, sr, seconds, profileDir) : runAs<float>(c, sr, seconds, profileDir);
+}
+
+var toJson(const Config& c, const Measurement& m)
+{
+    auto* o = new DynamicObject();
+    o->setProperty("oversampling",       1 << c.os);
+    o->setProperty("os_filter",          c.osFilter);
+    o->setProperty("os_adaptive",        c.adaptive);
+    o->setProperty("clip_mode",          c.clipMode);
+    o->setProperty("mb_bands",           c.bands);
+    o->setProperty("double_precision",   c.doublePrecision);
+    o->setProperty("block_size",         c.blockSize);
+    o->setProperty("channels",           c.channels);
+    o->setProperty("up_enable",          c.up);
+    o->setProperty("isp",                c.isp);
+    o->setProperty("mix",                c.dryMix ? 50 : 100);
+    o->setProperty("ns_per_sample",      m.nsPerSample);
+    o->setProperty("cycles_per_sample",  m.cyclesPerSample >= 0.0 ? var(m.cyclesPerSample) : var());
+    o->setProperty("worst_block_us",     m.worstBlockUs);
+    o->setProperty("realtime_instances", m.realtimeInstances);
+    return var(o);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInit;
+
+    double sr = 48000.0, seconds = 1.0;
+    bool quick = false;
+    File jsonFile, profileDir;
+    Array<int> channelCounts { 1, 2 };
+    int osFilter = 1, clipMode = 0, bands = 0;
+    bool adaptive = false, doublePrecision = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const String a(argv[i]);
+        auto next = [&]() -> String { return (i + 1 < argc) ? String(argv[++i]) : String(); };
+        if      (a == "--quick")   quick = true;
+        else if (a == "--sr")      sr = jmax(8000.0, next().getDoubleValue());
+        else if (a == "--seconds") seconds = jmax(0.05, next().getDoubleValue());
+        else if (a == "--json")    jsonFile = File::getCurrentWorkingDirectory().getChildFile(next());
+        else if (a == "--adaptive") adaptive = true;
+        else if (a == "--double")   doublePrecision = true;
+        else if (a == "--profile")
+        {
+            profileDir = File::getCurrentWorkingDirectory().getChildFile(next());
+            if (! HotPathProfiler::enabled) { std::cerr << "--profile needs a build with ZCLIP_PROFILE\n"; return 1; }
+        }
+        else if (a == "--adaa")
+        {
+            clipMode = next().getIntValue();
+            if (clipMode < 1 || clipMode > 2) { std::cerr << "--adaa takes 1 or 2\n"; return 1; }
+        }
+        else if (a == "--bands")
+        {
+            bands = next().getIntValue();
+            if (bands < 2 || bands > 4) { std::cerr << "--bands takes 2, 3 or 4\n"; return 1; }
+        }
+        else if (a == "--filter")
+        {
+            const String f = next();
+            osFilter = f == "fir" ? 0 : f == "iir" ? 1 : f == "iir-lo" ? 2 : -1;
+            if (osFilter < 0) { std::cerr << "--filter takes fir, iir or iir-lo\n"; return 1; }
+        }
+        else if (a == "--channels")
+        {
+            channelCounts.clear();
+            for (auto& t : StringArray::fromTokens(next(), ",", {}))
+                if (const int n = t.getIntValue(); n == 1 || n == 2 || n == 6 || n == 8 || n == 12)
+                    channelCounts.add(n);
+            if (channelCounts.isEmpty()) { std::cerr << "--channels takes a list of 1, 2, 6, 8, 12\n"; return 1; }
+        }
+        else
+        {
+            std::cout << "usage: zclip_bench [--quick] [--sr <rate>] [--seconds <per config>] [--channels 1,2,6,8,12] [--filter fir|iir|iir-lo] [--adaptive] [--adaa 1|2] [--bands 2|3|4] [--double] [--profile <dir>] [--json <file>]\n";
+            return a == "-h" || a == "--help" ? 0 : 1;
+        }
+    }
+
+    if (adaptive && (osFilter != 0 || clipMode != 0 || bands != 0))
+        std::cerr << "note: --adaptive only takes effect with --filter fir, no --adaa and no --bands\n";
+
+    const Array<int> blockSizes = quick ? Array<int>{ 64, 512, 4096 }
+                                        : Array<int>{ 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    Array<var> results;
+
+    std::cout << " os  block ch up isp mix   ns/sample  cyc/sample  worst(us)  instances\n";
+    for (int os = 0; os < 4; ++os)
+        for (int bs : blockSizes)
+            for (int ch : channelCounts)
+                for (int flags = 0; flags < 8; ++flags)
+                {
+                    Config c;
+                    c.os = os; c.osFilter = osFilter; c.adaptive = adaptive; c.clipMode = clipMode; c.bands = bands; c.doublePrecision = doublePrecision; c.blockSize = bs; c.channels = ch;
+                    c.up = (flags & 1) != 0; c.isp = (flags & 2) != 0; c.dryMix = (flags & 4) != 0;
+                    if (quick && flags != 0 && flags != 7) continue;
+
+                    const auto m = run(c, sr, seconds, profileDir);
+                    results.add(toJson(c, m));
+
+                    std::cout << String(1 << os).paddedLeft(' ', 2) << "x"
+                              << String(bs).paddedLeft(' ', 6)
+                              << String(ch).paddedLeft(' ', 3)
+                              << String(c.up ? "  y" : "  n") << String(c.isp ? "   y" : "   n")
+                              << String(c.dryMix ? "  50" : " 100")
+                              << String(m.nsPerSample, 3).paddedLeft(' ', 12)
+                              << (m.cyclesPerSample >= 0.0 ? String(m.cyclesPerSample, 2) : String("-")).paddedLeft(' ', 12)
+                              << String(m.worstBlockUs, 1).paddedLeft(' ', 11)
+                              << String(m.realtimeInstances, 1).paddedLeft(' ', 11) << "\n";
+                }
+
+    if (jsonFile != File())
+    {
+        auto* root = new DynamicObject();
+        root->setProperty("sample_rate", sr);
+        root->setProperty("seconds_per_config", seconds);
+        root->setProperty("os_filter", osFilter);
+        root->setProperty("simd_width", SimdF::width);
+        root->setProperty("cycle_counter", ZCLIP_HAS_TSC ? "tsc" : "none");
+        root->setProperty("results", results);
+        if (! jsonFile.replaceWithText(JSON::toString(var(root))))
+        {
+            std::cerr << "cannot write " << jsonFile.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include <juce_audio_utils/juce_audio_utils.h>
+#include "PluginProcessor.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+using namespace juce;
+
+namespace
+{
+struct Options
+{
+    StringArray inputs;
+    File outputDir, preset;
+    StringPairArray overrides;
+    String format;
+    int jobs = 0, blockSize = 512, bits = 0;
+};
+
+struct Result
+{
+    bool ok = false;
+    String message;
+    double audioSeconds = 0.0, wallSeconds = 0.0, dspSeconds = 0.0;
+    MeterSnapshot meters;
+};
+
+void printUsage()
+{
+    std::cout <<
+        "usage: zclip_render [options] <input.wav|flac> [more inputs...]\n"
+        "  -o, --output-dir <dir>   write results here (default: next to each input)\n"
+        "  -p, --preset <file>      plugin state: APVTS XML or binary state from the plugin\n"
+        "  -s, --set <id>=<value>   override one parameter, e.g. --set ceiling=-1 --set os=8x\n"
+        "  -j, --jobs <n>           worker threads, one processor each (default: all cores)\n"
+        "  -b, --block <n>          processing block size (default: 512)\n"
+        "  -f, --format wav|flac    output format (default: same as input)\n"
+        "      --bits <n>           output bit depth (default: same as input)\n";
+}
+
+bool parseArgs(int argc, char* argv[], Options& o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const String a(argv[i]);
+        auto next = [&]() -> String { return (i + 1 < argc) ? String(argv[++i]) : String(); };
+
+        if      (a == "-o" || a == "--output-dir") o.outputDir = File::getCurrentWorkingDirectory().getChildFile(next());
+        else if (a == "-p" || a == "--preset")     o.preset    = File::getCurrentWorkingDirectory().getChildFile(next());
+        else if (a == "-j" || a == "--jobs")       o.jobs      = next().getIntValue();
+        else if (a == "-b" || a == "--block")      o.blockSize = next().getIntValue();
+        else if (a == "-f" || a == "--format")     o.format    = next().toLowerCase();
+        else if (a == "--bits")                    o.bits      = next().getIntValue();
+        else if (a == "-s" || a == "--set")
+        {
+            const String kv = next();
+            if (! kv.containsChar('=')) { std::cerr << "bad --set value: " << kv << "\n"; return false; }
+            o.overrides.set(kv.upToFirstOccurrenceOf("=", false, false).trim(),
+                            kv.fromFirstOccurrenceOf("=", false, false).trim());
+        }
+        else if (a == "-h" || a == "--help") return false;
+        else if (a.startsWith("-")) { std::cerr << "unknown option: " << a << "\n"; return false; }
+        else o.inputs.add(File::getCurrentWorkingDirectory().getChildFile(a).getFullPathName());
+    }
+
+    if (o.jobs <= 0)      o.jobs = jmax(1, SystemStats::getNumCpus());
+    if (o.blockSize <= 0) o.blockSize = 512;
+    if (o.format.isNotEmpty() && o.format != "wav" && o.format != "flac")
+    {
+        std::cerr << "unsupported format: " << o.format << "\n";
+        return false;
+    }
+    return o.inputs.size() > 0;
+}
+
+bool applySettings(ZClipAudioProcessor& proc, const Options& o, String& error)
+{
+    if (o.preset != File())
+    {
+        if (! o.preset.existsAsFile()) { error = "preset not found: " + o.preset.getFullPathName(); return false; }
+
+        if (auto xml = XmlDocument::parse(o.preset))
+        {
+            auto state = ValueTree::fromXml(*xml);
+            if (! state.hasType(proc.apvts.state.getType())) { error = "preset is not a Z-Clip state"; return false; }
+            proc.apvts.replaceState(state);
+        }
+        else
+        {
+            MemoryBlock mb;
+            o.preset.loadFileAsData(mb);
+            proc.setStateInformation(mb.getData(), (int) mb.getSize());
+        }
+    }
+
+    for (auto& id : o.overrides.getAllKeys())
+    {
+        auto* param = proc.apvts.getParameter(id);
+        if (param == nullptr) { error = "unknown parameter: " + id; return false; }
+        param->setValueNotifyingHost(param->getValueForText(o.overrides[id]));
+    }
+    return true;
+}
+
+AudioFormat* formatFor(AudioFormatManager& fm, const File& in, const Options& o)
+{
+    const String ext = o.format.isNotEmpty() ? "." + o.format : in.getFileExtension();
+    return fm.findFormatForFileExtension(ext);
+}
+
+File outputFileFor(const File& in, const Options& o)
+{
+    const String ext = o.format.isNotEmpty() ? "." + o.format : in.getFileExtension();
+    const File dir   = (o.outputDir != File()) ? o.outputDir : in.getParentDirectory();
+    return dir.getChildFile(in.getFileNameWithoutExtension() + "_zclip" + ext);
+}
+
+Result renderFile(ZClipAudioProcessor& proc, AudioFormatManager& fm, const File& in, const Options& o)
+{
+    Result r;
+    std::unique_ptr<AudioFormatReader> reader(fm.createReaderFor(in));
+    if (reader == nullptr) { r.message = "cannot read " + in.getFullPathName(); return r; }
+
+    const int    numCh = (int) reader->numChannels;
+    const double sr    = reader->sampleRate;
+    const int64  total = reader->lengthInSamples;
+    const int    block = o.blockSize;
+
+    // canonicalChannelSet() has no 12-channel entry; treat those files as 7.1.4.
+    const auto set = numCh == 12 ? AudioChannelSet::create7point1point4() : AudioChannelSet::canonicalChannelSet(numCh);
+    AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(set);
+    layout.outputBuses.add(set);
+    if (! proc.setBusesLayout(layout)) { r.message = String(numCh) + "-channel input is not supported"; return r; }
+
+    proc.setNonRealtime(true);
+    proc.setRateAndBufferSizeDetails(sr, block);
+    proc.prepareToPlay(sr, block);
+    const int latency = proc.getLatencySamples();
+
+    auto* format = formatFor(fm, in, o);
+    if (format == nullptr) { r.message = "no writer for " + in.getFileExtension(); return r; }
+
+    int bits = o.bits > 0 ? o.bits : (int) reader->bitsPerSample;
+    if (! format->getPossibleBitDepths().contains(bits))
+        bits = format->getPossibleBitDepths().isEmpty() ? 24 : format->getPossibleBitDepths().getLast();
+
+    const File out = outputFileFor(in, o);
+    out.deleteFile();
+    std::unique_ptr<OutputStream> stream(out.createOutputStream());
+    if (stream == nullptr) { r.message = "cannot write " + out.getFullPathName(); return r; }
+
+    std::unique_ptr<AudioFormatWriter> writer(format->createWriterFor(stream.get(), sr, (unsigned int) numCh, bits, {}, 0));
+    if (writer == nullptr) { r.message = "cannot create writer for " + out.getFullPathName(); return r; }
+    stream.release();
+
+    AudioBuffer<float> buffer(numCh, block);
+    MidiBuffer midi;
+    const double wallStart = Time::getMillisecondCounterHiRes();
+    double dspMs = 0.0;
+
+    // Feed the file plus `latency` samples of silence, and drop the first
+    // `latency` output samples, so the result lines up with the input.
+    int64 readPos = 0, written = 0, toSkip = latency;
+    while (written < total)
+    {
+        const int n = (int) jmin<int64>(block, total + latency - readPos);
+        if (n <= 0) break;
+
+        buffer.clear();
+        if (readPos < total)
+            reader->read(&buffer, 0, (int) jmin<int64>(n, total - readPos), readPos, true, true);
+        readPos += n;
+
+        AudioBuffer<float> view(buffer.getArrayOfWritePointers(), numCh, n);
+        const double t0 = Time::getMillisecondCounterHiRes();
+        proc.processBlock(view, midi);
+        dspMs += Time::getMillisecondCounterHiRes() - t0;
+
+        const int skip  = (int) jmin<int64>(toSkip, n);
+        toSkip -= skip;
+        const int count = (int) jmin<int64>(n - skip, total - written);
+        if (count > 0 && ! writer->writeFromAudioSampleBuffer(view, skip, count))
+        {
+            r.message = "write failed for " + out.getFullPathName();
+            return r;
+        }
+        written += jmax(0, count);
+    }
+
+    writer.reset();
+    proc.flushMeters();
+    proc.readMeters(r.meters);
+    proc.releaseResources();
+
+    r.ok           = true;
+    r.audioSeconds = (double) total / sr;
+    r.wallSeconds  = (Time::getMillisecondCounterHiRes() - wallStart) * 0.001;
+    r.dspSeconds   = dspMs * 0.001;
+    r.message      = out.getFullPathName();
+    return r;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInit;
+
+    Options opts;
+    if (! parseArgs(argc, argv, opts)) { printUsage(); return 1; }
+    if (opts.outputDir != File() && ! opts.outputDir.createDirectory())
+    {
+        std::cerr << "cannot create " << opts.outputDir.getFullPathName() << "\n";
+        return 1;
+    }
+
+    const int numWorkers = jmin(opts.jobs, opts.inputs.size());
+
+    // Processors are built and configured here, on the message thread; each
+    // worker then owns one for its whole lifetime.
+    OwnedArray<ZClipAudioProcessor> processors;
+    for (int w = 0; w < numWorkers; ++w)
+    {
+        auto* proc = processors.add(new ZClipAudioProcessor());
+        String error;
+        if (! applySettings(*proc, opts, error)) { std::cerr << error << "\n"; return 1; }
+    }
+
+    std::atomic<int> nextFile { 0 }, failures { 0 };
+    CriticalSection printLock;
+    std::vector<std::thread> workers;
+
+    for (int w = 0; w < numWorkers; ++w)
+        workers.emplace_back([&, w]
+        {
+            AudioFormatManager fm;
+            fm.registerBasicFormats();
+
+            for (int i = nextFile++; i < opts.inputs.size(); i = nextFile++)
+            {
+                const File in(opts.inputs[i]);
+                const Result r = renderFile(*processors[w], fm, in, opts);
+
+                const ScopedLock sl(printLock);
+                if (! r.ok)
+                {
+                    ++failures;
+                    std::cerr << "FAILED " << in.getFileName() << ": " << r.message << "\n";
+                    continue;
+                }
+                std::cout << in.getFileName() << " -> " << r.message
+                          << "  " << String(r.audioSeconds, 2) << " s audio"
+                          << ", realtime factor " << String(r.audioSeconds / jmax(1.0e-9, r.wallSeconds), 1) << "x"
+                          << " (dsp only " << String(r.audioSeconds / jmax(1.0e-9, r.dspSeconds), 1) << "x)\n";
+
+                const auto& m = r.meters;
+                const double clipPct = m.consideredSamples > 0 ? 100.0 * (double) m.clippedSamples / (double) m.consideredSamples : 0.0;
+                std::cout << "    integrated " << String(m.integratedLufs, 1) << " LUFS"
+                          << ", true peak " << String(m.truePeakHoldDb, 2) << " dBTP"
+                          << ", max gain reduction " << String(m.maxGainReductionDb, 2) << " dB"
+                          << ", clipped " << String(clipPct, 3) << "%\n";
+            }
+        });
+
+    for (auto& t : workers) t.join();
+    return failures.load() > 0 ? 2 : 0;
+}